@@ -72,6 +72,45 @@ FPathFollowingRequestResult ASVONAIController::MoveTo(const FAIMoveRequest& Move
 		ResultData.MoveId = GetPathFollowingComponent()->RequestMoveWithImmediateFinish(EPathFollowingResult::Success);
 		ResultData.Code = EPathFollowingRequestResult::AlreadyAtGoal;
 	}
+	else if (bCanRequestMove && myUseAsyncPathfinding)
+	{
+		const FVector goalLocation = MoveRequest.IsMoveToActorRequest() ? MoveRequest.GetGoalActor()->GetActorLocation() : MoveRequest.GetGoalLocation();
+
+		// A fresh path that isn't ready yet, so path following waits on it instead of moving
+		myNavPath = MakeShareable<FNavigationPath>(new FNavigationPath());
+
+		const FAIRequestID RequestID = RequestMove(MoveRequest, myNavPath);
+
+		if (RequestID.IsValid())
+		{
+			TWeakObjectPtr<ASVONAIController> weakThis(this);
+			FNavPathSharedPtr path = myNavPath;
+
+			FSVONPathQueryHandle query = SVONNavComponent->FindPathAsync(GetPawn()->GetActorLocation(), goalLocation, FSVONPathQueryComplete::CreateLambda([weakThis, path, RequestID](const SVONPathQueryResult& aResult)
+			{
+				if (weakThis.IsValid())
+				{
+					weakThis->OnAsyncPathResult(aResult, path, RequestID);
+				}
+			}));
+
+			if (query.IsValid())
+			{
+				UE_VLOG(this, LogAINavigation, Log, TEXT("SVON Pathfinding started, waiting for path"));
+				if (OutPath)
+				{
+					*OutPath = myNavPath;
+				}
+				bAllowStrafe = MoveRequest.CanStrafe();
+				ResultData.MoveId = RequestID;
+				ResultData.Code = EPathFollowingRequestResult::RequestSuccessful;
+			}
+			else
+			{
+				GetPathFollowingComponent()->AbortMove(*this, FPathFollowingResultFlags::InvalidPath, RequestID);
+			}
+		}
+	}
 	else if (bCanRequestMove)
 	{
 		SVONNavComponent->FindPathImmediate(GetPawn()->GetActorLocation(), MoveRequest.IsMoveToActorRequest() ? MoveRequest.GetGoalActor()->GetActorLocation() : MoveRequest.GetGoalLocation(), &myNavPath);
@@ -81,7 +120,10 @@ FPathFollowingRequestResult ASVONAIController::MoveTo(const FAIMoveRequest& Move
 		if(RequestID.IsValid())
 		{
 			UE_VLOG(this, LogAINavigation, Log, TEXT("SVON Pathfinding successful, moving"));
-			*OutPath = myNavPath;
+			if (OutPath)
+			{
+				*OutPath = myNavPath;
+			}
 			bAllowStrafe = MoveRequest.CanStrafe();
 			ResultData.MoveId = RequestID;
 			ResultData.Code = EPathFollowingRequestResult::RequestSuccessful;
@@ -96,3 +138,42 @@ FPathFollowingRequestResult ASVONAIController::MoveTo(const FAIMoveRequest& Move
 
 	return ResultData;
 }
+
+void ASVONAIController::OnAsyncPathResult(const SVONPathQueryResult& aResult, FNavPathSharedPtr aPath, FAIRequestID aRequestID)
+{
+	// A newer move has replaced this one
+	if (myNavPath != aPath || !GetPathFollowingComponent() || GetPathFollowingComponent()->GetCurrentRequestId() != aRequestID)
+	{
+		return;
+	}
+
+	const bool isPartial = aResult.myIsPartial || aResult.myStatus == ESVONPathStatus::Partial;
+
+	if (aResult.myStatus == ESVONPathStatus::Failed)
+	{
+		UE_VLOG(this, LogAINavigation, Log, TEXT("SVON Pathfinding failed, aborting move"));
+		GetPathFollowingComponent()->AbortMove(*this, FPathFollowingResultFlags::InvalidPath, aRequestID);
+		return;
+	}
+
+	TArray<FNavPathPoint>& points = aPath->GetPathPoints();
+	points.Reset();
+	for (const FVector& point : aResult.myPath.GetPoints())
+	{
+		points.Add(point);
+	}
+
+	// Only head for the goal once the path actually reaches it. The query snapped it out of blocked space, so use its point
+	if (!isPartial)
+	{
+		points.Add(aResult.myTargetPosition);
+	}
+
+	aPath->SetIsPartial(isPartial);
+	aPath->MarkReady();
+
+	// Tells the path following component to pick up the new points, whether it's waiting or already moving along a partial path
+	aPath->DoneUpdating(ENavPathUpdateType::NavigationChanged);
+
+	UE_VLOG(this, LogAINavigation, Log, TEXT("SVON Pathfinding %s, moving"), isPartial ? TEXT("partial") : TEXT("successful"));
+}
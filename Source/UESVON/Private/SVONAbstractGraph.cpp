@@ -0,0 +1,409 @@
+#include "SVONAbstractGraph.h"
+#include "SVONVolume.h"
+#include "Algo/Reverse.h"
+
+struct SVONGraphSearchEntry
+{
+	SVONLink myLink;
+	float myCost;
+};
+
+struct SVONAbstractSearchEntry
+{
+	int32 myNode;
+	float myGScore;
+	float myFScore;
+};
+
+struct SVONCrossing
+{
+	SVONLink myFrom;
+	SVONLink myTo;
+	float myScore;
+	float myCost;
+};
+
+static float SVONLinkDistance(const ASVONVolume& aVolume, const SVONLink& aStart, const SVONLink& aTarget)
+{
+	FVector startPos, endPos;
+	aVolume.GetLinkPosition(aStart, startPos);
+	aVolume.GetLinkPosition(aTarget, endPos);
+	return (startPos - endPos).Size();
+}
+
+void SVONAbstractGraph::Reset()
+{
+	myNodes.Reset();
+	myClusterEntrances.Reset();
+	myClusterIndices.Reset();
+	myIntraPaths.Reset();
+}
+
+uint64 SVONAbstractGraph::GetClusterKey(const ASVONVolume& aVolume, const SVONLink& aLink) const
+{
+	const layerindex_t layer = aLink.GetLayerIndex();
+	const mortoncode_t code = aVolume.GetNodeCode(layer, aLink.GetNodeIndex());
+
+	// Finer nodes belong to their ancestor on the cluster layer, coarser free nodes are clusters in their own right
+	if (layer < myClusterLayer)
+	{
+		return ((uint64)myClusterLayer << 58) | (code >> (3 * (myClusterLayer - layer)));
+	}
+	return ((uint64)layer << 58) | code;
+}
+
+void SVONAbstractGraph::Build(const ASVONVolume& aVolume, layerindex_t aClusterLayer)
+{
+	Reset();
+	myClusterLayer = aClusterLayer;
+
+	TArray<uint64> clusterKeys;
+	TArray<FVector> clusterCentres;
+
+	auto getCluster = [&](const SVONLink& aLink)
+	{
+		const uint64 key = GetClusterKey(aVolume, aLink);
+		if (const int32* index = myClusterIndices.Find(key))
+		{
+			return *index;
+		}
+
+		FVector centre;
+		aVolume.GetNodePosition(key >> 58, key & ((1ULL << 58) - 1), centre);
+
+		const int32 index = myClusterEntrances.AddDefaulted();
+		myClusterIndices.Add(key, index);
+		clusterKeys.Add(key);
+		clusterCentres.Add(centre);
+		return index;
+	};
+
+	// Find every link pair that crosses between two clusters, keeping the one nearest the middle of each shared face
+	TMap<TPair<int32, int32>, SVONCrossing> crossings;
+	TArray<SVONLink> neighbours;
+
+	aVolume.ForEachNavLink([&](const SVONLink& aLink)
+	{
+		const int32 fromCluster = getCluster(aLink);
+
+		neighbours.Reset();
+		aVolume.GetNavNeighbours(aLink, neighbours);
+
+		for (const SVONLink& neighbour : neighbours)
+		{
+			const int32 toCluster = getCluster(neighbour);
+			if (toCluster == fromCluster)
+				continue;
+
+			FVector fromPos, toPos;
+			aVolume.GetLinkPosition(aLink, fromPos);
+			aVolume.GetLinkPosition(neighbour, toPos);
+
+			const FVector faceCentre = (clusterCentres[fromCluster] + clusterCentres[toCluster]) * 0.5f;
+			const float score = ((fromPos + toPos) * 0.5f - faceCentre).SizeSquared();
+
+			const TPair<int32, int32> clusterPair(fromCluster, toCluster);
+			SVONCrossing* existing = crossings.Find(clusterPair);
+			if (!existing || score < existing->myScore)
+			{
+				crossings.Add(clusterPair, SVONCrossing{ aLink, neighbour, score, (fromPos - toPos).Size() });
+			}
+		}
+	});
+
+	// Each end of a crossing is an entrance node
+	TMap<SVONLink, int32> linkNodes;
+
+	auto getNode = [&](const SVONLink& aLink, int32 aCluster)
+	{
+		if (const int32* index = linkNodes.Find(aLink))
+		{
+			return *index;
+		}
+
+		const int32 index = myNodes.AddDefaulted();
+		myNodes[index].myLink = aLink;
+		myNodes[index].myCluster = aCluster;
+		aVolume.GetLinkPosition(aLink, myNodes[index].myPosition);
+
+		linkNodes.Add(aLink, index);
+		myClusterEntrances[aCluster].Add(index);
+		return index;
+	};
+
+	for (const TPair<TPair<int32, int32>, SVONCrossing>& crossing : crossings)
+	{
+		const int32 from = getNode(crossing.Value.myFrom, crossing.Key.Key);
+		const int32 to = getNode(crossing.Value.myTo, crossing.Key.Value);
+
+		myNodes[from].myEdges.Add(SVONAbstractEdge{ to, crossing.Value.myCost, INDEX_NONE });
+		myNodes[to].myEdges.Add(SVONAbstractEdge{ from, crossing.Value.myCost, INDEX_NONE });
+	}
+
+	// Precompute the distances, and paths, between each cluster's entrances
+	TMap<SVONLink, float> costs;
+	TMap<SVONLink, SVONLink> cameFrom;
+
+	for (int32 cluster = 0; cluster < myClusterEntrances.Num(); cluster++)
+	{
+		const TArray<int32>& entrances = myClusterEntrances[cluster];
+		if (entrances.Num() < 2)
+			continue;
+
+		TSet<SVONLink> targets;
+		for (int32 entrance : entrances)
+		{
+			targets.Add(myNodes[entrance].myLink);
+		}
+
+		for (int32 from : entrances)
+		{
+			SearchCluster(aVolume, myNodes[from].myLink, clusterKeys[cluster], targets, costs, cameFrom);
+
+			for (int32 to : entrances)
+			{
+				const float* cost = costs.Find(myNodes[to].myLink);
+				if (to == from || !cost)
+					continue;
+
+				const int32 pathIndex = myIntraPaths.AddDefaulted();
+				WalkBack(cameFrom, myNodes[to].myLink, myIntraPaths[pathIndex]);
+
+				myNodes[from].myEdges.Add(SVONAbstractEdge{ to, *cost, pathIndex });
+			}
+		}
+	}
+
+	UE_LOG(UESVON, Display, TEXT("Abstract Graph Clusters-Entrances : %d-%d"), myClusterEntrances.Num(), myNodes.Num());
+}
+
+void SVONAbstractGraph::SearchCluster(const ASVONVolume& aVolume, const SVONLink& aFrom, uint64 aClusterKey, const TSet<SVONLink>& aTargets, TMap<SVONLink, float>& oCosts, TMap<SVONLink, SVONLink>& oCameFrom) const
+{
+	auto heapPredicate = [](const SVONGraphSearchEntry& A, const SVONGraphSearchEntry& B)
+	{
+		return A.myCost < B.myCost;
+	};
+
+	oCosts.Reset();
+	oCameFrom.Reset();
+
+	TArray<SVONGraphSearchEntry> open;
+	TSet<SVONLink> settled;
+	TArray<SVONLink> neighbours;
+
+	oCosts.Add(aFrom, 0.f);
+	oCameFrom.Add(aFrom, aFrom);
+	open.HeapPush({ aFrom, 0.f }, heapPredicate);
+
+	int32 remaining = aTargets.Num();
+
+	while (open.Num() > 0 && remaining > 0)
+	{
+		SVONGraphSearchEntry current;
+		open.HeapPop(current, heapPredicate);
+
+		bool alreadySettled = false;
+		settled.Add(current.myLink, &alreadySettled);
+		if (alreadySettled)
+			continue;
+
+		if (aTargets.Contains(current.myLink))
+		{
+			remaining--;
+		}
+
+		neighbours.Reset();
+		aVolume.GetNavNeighbours(current.myLink, neighbours);
+
+		for (const SVONLink& neighbour : neighbours)
+		{
+			if (settled.Contains(neighbour) || GetClusterKey(aVolume, neighbour) != aClusterKey)
+				continue;
+
+			const float cost = current.myCost + SVONLinkDistance(aVolume, current.myLink, neighbour);
+			const float* existing = oCosts.Find(neighbour);
+			if (existing && *existing <= cost)
+				continue;
+
+			oCosts.Add(neighbour, cost);
+			oCameFrom.Add(neighbour, current.myLink);
+			open.HeapPush({ neighbour, cost }, heapPredicate);
+		}
+	}
+}
+
+void SVONAbstractGraph::WalkBack(const TMap<SVONLink, SVONLink>& aCameFrom, SVONLink aLink, TArray<SVONLink>& oLinks)
+{
+	oLinks.Reset();
+	oLinks.Add(aLink);
+
+	while (aCameFrom.Contains(aLink) && !(aCameFrom[aLink] == aLink))
+	{
+		aLink = aCameFrom[aLink];
+		oLinks.Add(aLink);
+	}
+
+	// We collected it goal first
+	Algo::Reverse(oLinks);
+}
+
+bool SVONAbstractGraph::FindPath(const ASVONVolume& aVolume, const SVONLink& aStart, const SVONLink& aGoal, TArray<SVONLink>& oLinks) const
+{
+	if (!IsBuilt())
+	{
+		return false;
+	}
+
+	const uint64 startKey = GetClusterKey(aVolume, aStart);
+	const uint64 goalKey = GetClusterKey(aVolume, aGoal);
+
+	const int32* startClusterPtr = myClusterIndices.Find(startKey);
+	const int32* goalClusterPtr = myClusterIndices.Find(goalKey);
+
+	// A local query, the normal search is the right tool
+	if (startKey == goalKey || !startClusterPtr || !goalClusterPtr)
+	{
+		return false;
+	}
+
+	const int32 startCluster = *startClusterPtr;
+	const int32 goalCluster = *goalClusterPtr;
+
+	// The two local searches, out from the start and goal to the entrances of their clusters
+	TSet<SVONLink> startTargets, goalTargets;
+	for (int32 entrance : myClusterEntrances[startCluster])
+	{
+		startTargets.Add(myNodes[entrance].myLink);
+	}
+	for (int32 entrance : myClusterEntrances[goalCluster])
+	{
+		goalTargets.Add(myNodes[entrance].myLink);
+	}
+
+	TMap<SVONLink, float> startCosts, goalCosts;
+	TMap<SVONLink, SVONLink> startCameFrom, goalCameFrom;
+
+	SearchCluster(aVolume, aStart, startKey, startTargets, startCosts, startCameFrom);
+	SearchCluster(aVolume, aGoal, goalKey, goalTargets, goalCosts, goalCameFrom);
+
+	// The abstract search. Node index myNodes.Num() stands in for the goal
+	const int32 goalNode = myNodes.Num();
+
+	FVector goalPosition;
+	aVolume.GetLinkPosition(aGoal, goalPosition);
+
+	auto heuristic = [&](int32 aNode)
+	{
+		return aNode == goalNode ? 0.f : (myNodes[aNode].myPosition - goalPosition).Size();
+	};
+
+	auto heapPredicate = [](const SVONAbstractSearchEntry& A, const SVONAbstractSearchEntry& B)
+	{
+		return A.myFScore < B.myFScore;
+	};
+
+	TArray<SVONAbstractSearchEntry> open;
+	TMap<int32, float> gScores;
+	// Where we came from, and the intra-cluster path we came along (INDEX_NONE for crossings and the start)
+	TMap<int32, TPair<int32, int32>> cameFrom;
+
+	for (int32 entrance : myClusterEntrances[startCluster])
+	{
+		if (const float* cost = startCosts.Find(myNodes[entrance].myLink))
+		{
+			gScores.Add(entrance, *cost);
+			cameFrom.Add(entrance, TPair<int32, int32>(INDEX_NONE, INDEX_NONE));
+			open.HeapPush({ entrance, *cost, *cost + heuristic(entrance) }, heapPredicate);
+		}
+	}
+
+	bool foundGoal = false;
+
+	while (open.Num() > 0)
+	{
+		SVONAbstractSearchEntry current;
+		open.HeapPop(current, heapPredicate);
+
+		if (current.myGScore > gScores[current.myNode])
+			continue;
+
+		if (current.myNode == goalNode)
+		{
+			foundGoal = true;
+			break;
+		}
+
+		auto relax = [&](int32 aTarget, float aCost, int32 aPathIndex)
+		{
+			const float gScore = current.myGScore + aCost;
+			const float* existing = gScores.Find(aTarget);
+			if (existing && *existing <= gScore)
+				return;
+
+			gScores.Add(aTarget, gScore);
+			cameFrom.Add(aTarget, TPair<int32, int32>(current.myNode, aPathIndex));
+			open.HeapPush({ aTarget, gScore, gScore + heuristic(aTarget) }, heapPredicate);
+		};
+
+		const SVONAbstractNode& node = myNodes[current.myNode];
+
+		if (node.myCluster == goalCluster)
+		{
+			if (const float* cost = goalCosts.Find(node.myLink))
+			{
+				relax(goalNode, *cost, INDEX_NONE);
+			}
+		}
+
+		for (const SVONAbstractEdge& edge : node.myEdges)
+		{
+			relax(edge.myTarget, edge.myCost, edge.myPathIndex);
+		}
+	}
+
+	if (!foundGoal)
+	{
+		return false;
+	}
+
+	// Collect the abstract path, goal first
+	TArray<int32> abstractPath;
+	int32 node = cameFrom[goalNode].Key;
+	while (node != INDEX_NONE)
+	{
+		abstractPath.Add(node);
+		node = cameFrom[node].Key;
+	}
+	Algo::Reverse(abstractPath);
+
+	// Start to the first entrance
+	WalkBack(startCameFrom, myNodes[abstractPath[0]].myLink, oLinks);
+
+	// Entrance to entrance, along cached paths inside clusters and single steps across faces
+	for (int32 i = 1; i < abstractPath.Num(); i++)
+	{
+		const int32 pathIndex = cameFrom[abstractPath[i]].Value;
+		if (pathIndex != INDEX_NONE)
+		{
+			const TArray<SVONLink>& intraPath = myIntraPaths[pathIndex];
+			for (int32 j = 1; j < intraPath.Num(); j++)
+			{
+				oLinks.Add(intraPath[j]);
+			}
+		}
+		else
+		{
+			oLinks.Add(myNodes[abstractPath[i]].myLink);
+		}
+	}
+
+	// Last entrance to the goal. That search ran from the goal, so walk it the other way
+	TArray<SVONLink> goalPath;
+	WalkBack(goalCameFrom, myNodes[abstractPath.Last()].myLink, goalPath);
+	for (int32 j = goalPath.Num() - 2; j >= 0; j--)
+	{
+		oLinks.Add(goalPath[j]);
+	}
+
+	return true;
+}
@@ -0,0 +1,289 @@
+#include "UESVON.h"
+#include "SVONVolume.h"
+#include "SVONPathFinder.h"
+#include "SVONMediator.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+
+/* A named set of search options to compare */
+struct SVONBenchmarkMode
+{
+	const TCHAR* myName;
+	SVONPathFinderSettings mySettings;
+};
+
+static TArray<SVONBenchmarkMode> GetBenchmarkModes()
+{
+	TArray<SVONBenchmarkMode> modes;
+
+	modes.Add({ TEXT("AStar"), SVONPathFinderSettings() });
+
+	SVONPathFinderSettings bidirectional;
+	bidirectional.myUseBidirectionalSearch = true;
+	modes.Add({ TEXT("Bidirectional"), bidirectional });
+
+	SVONPathFinderSettings unitCost;
+	unitCost.myPathCostType = ESVONPathCostType::UnitCost;
+	modes.Add({ TEXT("UnitCost"), unitCost });
+
+	SVONPathFinderSettings sizeScaled;
+	sizeScaled.myPathCostType = ESVONPathCostType::SizeScaled;
+	modes.Add({ TEXT("SizeScaled"), sizeScaled });
+
+	SVONPathFinderSettings weighted;
+	weighted.myHeuristicWeight = 2.f;
+	modes.Add({ TEXT("Weighted2"), weighted });
+
+	SVONPathFinderSettings jumpPoint;
+	jumpPoint.myUseJumpPointSearch = true;
+	modes.Add({ TEXT("JumpPoint"), jumpPoint });
+
+	SVONPathFinderSettings thetaStar;
+	thetaStar.myUseThetaStar = true;
+	modes.Add({ TEXT("ThetaStar"), thetaStar });
+
+	return modes;
+}
+
+/* Random pairs of connected nav links, the same pairs for a given seed */
+static void GatherBenchmarkQueries(const ASVONVolume& aVolume, int32 aNumQueries, int32 aSeed, TArray<SVONPathRequest>& oRequests)
+{
+	TArray<SVONLink> links;
+	aVolume.ForEachNavLink([&](const SVONLink& aLink) { links.Add(aLink); });
+
+	if (links.Num() < 2)
+		return;
+
+	FRandomStream random(aSeed);
+
+	// Give up on pairs eventually, in case most of the volume is disconnected
+	for (int32 attempt = 0; oRequests.Num() < aNumQueries && attempt < aNumQueries * 10; attempt++)
+	{
+		const SVONLink& start = links[random.RandHelper(links.Num())];
+		const SVONLink& target = links[random.RandHelper(links.Num())];
+
+		if (start == target || !aVolume.AreLinksConnected(start, target))
+			continue;
+
+		oRequests.Add(SVONPathRequest(start, target));
+	}
+}
+
+static float GetPathLength(const SVONPath& aPath)
+{
+	float length = 0.f;
+	const TArray<FVector>& points = aPath.GetPoints();
+	for (int32 i = 1; i < points.Num(); i++)
+	{
+		length += FVector::Dist(points[i - 1], points[i]);
+	}
+	return length;
+}
+
+/* svon.BenchmarkPathModes [NumQueries] [Seed] - runs the same queries through each search mode on every volume */
+static void BenchmarkPathModes(const TArray<FString>& aArgs, UWorld* aWorld)
+{
+	const int32 numQueries = aArgs.Num() > 0 ? FMath::Max(FCString::Atoi(*aArgs[0]), 1) : 100;
+	const int32 seed = aArgs.Num() > 1 ? FCString::Atoi(*aArgs[1]) : 1;
+
+	const TArray<SVONBenchmarkMode> modes = GetBenchmarkModes();
+
+	for (TActorIterator<ASVONVolume> it(aWorld); it; ++it)
+	{
+		ASVONVolume& volume = **it;
+		if (!volume.IsReadyForNavigation())
+			continue;
+
+		TArray<SVONPathRequest> requests;
+		GatherBenchmarkQueries(volume, numQueries, seed, requests);
+
+		UE_LOG(UESVON, Display, TEXT("Benchmarking %s, %i queries"), *volume.GetName(), requests.Num());
+
+		for (const SVONBenchmarkMode& mode : modes)
+		{
+			TArray<FVector> debugPoints;
+			SVONPathFinder pathFinder(volume, false, aWorld, debugPoints, mode.mySettings);
+
+			int64 totalIterations = 0;
+			int32 numComplete = 0;
+			float totalLength = 0.f;
+			int64 totalPoints = 0;
+
+			const double startTime = FPlatformTime::Seconds();
+
+			for (const SVONPathRequest& request : requests)
+			{
+				numComplete += pathFinder.FindPath(request.myStart, request.myTarget, nullptr);
+				totalIterations += pathFinder.GetNumIterations();
+				totalLength += GetPathLength(pathFinder.GetPath());
+				totalPoints += pathFinder.GetPath().GetPoints().Num();
+			}
+
+			const double totalMs = (FPlatformTime::Seconds() - startTime) * 1000.0;
+			const int32 divisor = FMath::Max(requests.Num(), 1);
+
+			UE_LOG(UESVON, Display, TEXT("  %-16s complete %i/%i, expansions %lld (avg %.1f), avg length %.1f, avg points %.1f, total %.2fms"),
+				mode.myName, numComplete, requests.Num(), totalIterations, (float)totalIterations / divisor, totalLength / divisor, (float)totalPoints / divisor, totalMs);
+		}
+	}
+}
+
+/* svon.BenchmarkRaycast [NumRays] [Seed] - compares octree raycasts against physics traces over the same random segments */
+static void BenchmarkRaycast(const TArray<FString>& aArgs, UWorld* aWorld)
+{
+	const int32 numRays = aArgs.Num() > 0 ? FMath::Max(FCString::Atoi(*aArgs[0]), 1) : 1000;
+	const int32 seed = aArgs.Num() > 1 ? FCString::Atoi(*aArgs[1]) : 1;
+
+	for (TActorIterator<ASVONVolume> it(aWorld); it; ++it)
+	{
+		ASVONVolume& volume = **it;
+		if (!volume.IsReadyForNavigation())
+			continue;
+
+		FRandomStream random(seed);
+		const FBox box(volume.GetOrigin() - volume.GetExtent(), volume.GetOrigin() + volume.GetExtent());
+
+		TArray<FVector> starts, ends;
+		for (int32 i = 0; i < numRays; i++)
+		{
+			starts.Add(FVector(random.FRandRange(box.Min.X, box.Max.X), random.FRandRange(box.Min.Y, box.Max.Y), random.FRandRange(box.Min.Z, box.Max.Z)));
+			ends.Add(FVector(random.FRandRange(box.Min.X, box.Max.X), random.FRandRange(box.Min.Y, box.Max.Y), random.FRandRange(box.Min.Z, box.Max.Z)));
+		}
+
+		int32 octreeHits = 0;
+		double startTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < numRays; i++)
+		{
+			SVONRaycastHit hit;
+			octreeHits += volume.Raycast(starts[i], ends[i], hit) ? 1 : 0;
+		}
+		const double octreeMs = (FPlatformTime::Seconds() - startTime) * 1000.0;
+
+		int32 physicsHits = 0;
+		FCollisionQueryParams params;
+		startTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < numRays; i++)
+		{
+			FHitResult hit;
+			physicsHits += aWorld->LineTraceSingleByChannel(hit, starts[i], ends[i], volume.myCollisionChannel, params) ? 1 : 0;
+		}
+		const double physicsMs = (FPlatformTime::Seconds() - startTime) * 1000.0;
+
+		UE_LOG(UESVON, Display, TEXT("%s, %i rays: octree %i hits in %.2fms, physics %i hits in %.2fms"),
+			*volume.GetName(), numRays, octreeHits, octreeMs, physicsHits, physicsMs);
+	}
+}
+
+/* svon.BenchmarkSmoothing [NumQueries] [Seed] [Spacing] - point counts and time for each smoothing stage */
+static void BenchmarkSmoothing(const TArray<FString>& aArgs, UWorld* aWorld)
+{
+	const int32 numQueries = aArgs.Num() > 0 ? FMath::Max(FCString::Atoi(*aArgs[0]), 1) : 100;
+	const int32 seed = aArgs.Num() > 1 ? FCString::Atoi(*aArgs[1]) : 1;
+
+	SVONPathFinderSettings settings;
+	settings.myStringPullPath = true;
+	settings.myResamplePath = true;
+	settings.myRemoveCollinearPoints = true;
+	if (aArgs.Num() > 2)
+	{
+		settings.myResampleSpacing = FCString::Atof(*aArgs[2]);
+	}
+
+	for (TActorIterator<ASVONVolume> it(aWorld); it; ++it)
+	{
+		ASVONVolume& volume = **it;
+		if (!volume.IsReadyForNavigation())
+			continue;
+
+		TArray<SVONPathRequest> requests;
+		GatherBenchmarkQueries(volume, numQueries, seed, requests);
+
+		TArray<FVector> debugPoints;
+		SVONPathFinder pathFinder(volume, false, aWorld, debugPoints, settings);
+
+		int64 rawPoints = 0, pulledPoints = 0, resampledPoints = 0, finalPoints = 0;
+		double pullMs = 0.0, resampleMs = 0.0, collinearMs = 0.0;
+
+		for (const SVONPathRequest& request : requests)
+		{
+			pathFinder.FindPath(request.myStart, request.myTarget, nullptr);
+
+			const SVONPathSmoothingStats& stats = pathFinder.GetSmoothingStats();
+			rawPoints += stats.myNumRawPoints;
+			pulledPoints += stats.myNumPulledPoints;
+			resampledPoints += stats.myNumResampledPoints;
+			finalPoints += stats.myNumFinalPoints;
+			pullMs += stats.myPullMilliseconds;
+			resampleMs += stats.myResampleMilliseconds;
+			collinearMs += stats.myCollinearMilliseconds;
+		}
+
+		UE_LOG(UESVON, Display, TEXT("Smoothing %s, %i queries"), *volume.GetName(), requests.Num());
+		UE_LOG(UESVON, Display, TEXT("  raw points %lld"), rawPoints);
+		UE_LOG(UESVON, Display, TEXT("  string pull   -> %lld points, %.2fms"), pulledPoints, pullMs);
+		UE_LOG(UESVON, Display, TEXT("  resample      -> %lld points, %.2fms"), resampledPoints, resampleMs);
+		UE_LOG(UESVON, Display, TEXT("  collinear     -> %lld points, %.2fms"), finalPoints, collinearMs);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkSmoothingCommand(
+	TEXT("svon.BenchmarkSmoothing"),
+	TEXT("Runs random queries with every smoothing stage on and logs point counts and time per stage. Args: [NumQueries] [Seed] [Spacing]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkSmoothing));
+
+/* svon.BenchmarkLocate [NumPositions] [Seed] - point location throughput, one at a time against batched */
+static void BenchmarkLocate(const TArray<FString>& aArgs, UWorld* aWorld)
+{
+	const int32 numPositions = aArgs.Num() > 0 ? FMath::Max(FCString::Atoi(*aArgs[0]), 1) : 10000;
+	const int32 seed = aArgs.Num() > 1 ? FCString::Atoi(*aArgs[1]) : 1;
+
+	for (TActorIterator<ASVONVolume> it(aWorld); it; ++it)
+	{
+		ASVONVolume& volume = **it;
+		if (!volume.IsReadyForNavigation())
+			continue;
+
+		FRandomStream random(seed);
+		const FBox box(volume.GetOrigin() - volume.GetExtent(), volume.GetOrigin() + volume.GetExtent());
+
+		TArray<FVector> positions;
+		positions.Reserve(numPositions);
+		for (int32 i = 0; i < numPositions; i++)
+		{
+			positions.Add(FVector(random.FRandRange(box.Min.X, box.Max.X), random.FRandRange(box.Min.Y, box.Max.Y), random.FRandRange(box.Min.Z, box.Max.Z)));
+		}
+
+		TArray<SVONLink> links;
+		links.SetNum(numPositions);
+
+		double startTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < numPositions; i++)
+		{
+			SVONMediator::GetLinkFromPosition(positions[i], volume, links[i]);
+		}
+		const double singleSeconds = FPlatformTime::Seconds() - startTime;
+
+		startTime = FPlatformTime::Seconds();
+		SVONMediator::GetLinksFromPositions(positions, volume, links);
+		const double batchSeconds = FPlatformTime::Seconds() - startTime;
+
+		UE_LOG(UESVON, Display, TEXT("%s, %i positions: single %.0f positions/s, batched %.0f positions/s"),
+			*volume.GetName(), numPositions, numPositions / FMath::Max(singleSeconds, 1e-9), numPositions / FMath::Max(batchSeconds, 1e-9));
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkLocateCommand(
+	TEXT("svon.BenchmarkLocate"),
+	TEXT("Logs point location throughput in positions per second, one at a time and batched. Args: [NumPositions] [Seed]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkLocate));
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkRaycastCommand(
+	TEXT("svon.BenchmarkRaycast"),
+	TEXT("Times octree raycasts against physics line traces over the same random segments. Args: [NumRays] [Seed]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkRaycast));
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkPathModesCommand(
+	TEXT("svon.BenchmarkPathModes"),
+	TEXT("Runs the same random queries through each pathfinding mode and logs expansions. Args: [NumQueries] [Seed]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkPathModes));
@@ -0,0 +1,186 @@
+#include "SVONLinearOctree.h"
+#include "SVONNode.h"
+#include "UESVON.h"
+
+bool SVONLinearOctree::Build(const TArray<TArray<SVONNode>>& aLayers)
+{
+	Reset();
+
+	myLayers.SetNum(aLayers.Num());
+
+	for (int32 layerIndex = 0; layerIndex < aLayers.Num(); layerIndex++)
+	{
+		const TArray<SVONNode>& nodes = aLayers[layerIndex];
+		SVONLinearLayer& layer = myLayers[layerIndex];
+
+		if (nodes.Num() > 0)
+		{
+			myTopLayer = layerIndex;
+		}
+
+		layer.myNumNodes = nodes.Num();
+		layer.myChildBits.AddZeroed((nodes.Num() + 63) / 64);
+		layer.myRanks.SetNumUninitialized(layer.myChildBits.Num());
+		layer.myNeighbours.SetNumUninitialized(nodes.Num() * 6);
+
+		for (int32 i = 0; i < nodes.Num(); i++)
+		{
+			if (nodes[i].myFirstChild.IsValid())
+			{
+				layer.myChildBits[i >> 6] |= 1ull << (i & 63);
+			}
+			for (int32 d = 0; d < 6; d++)
+			{
+				layer.myNeighbours[i * 6 + d] = nodes[i].myNeighbours[d];
+			}
+		}
+
+		uint32 rank = 0;
+		for (int32 w = 0; w < layer.myChildBits.Num(); w++)
+		{
+			layer.myRanks[w] = rank;
+			rank += FMath::CountBits(layer.myChildBits[w]);
+		}
+	}
+
+	for (const SVONNode& node : aLayers[myTopLayer])
+	{
+		myTopCodes.Add(node.myCode);
+	}
+
+	// Only use the layout if every link it derives matches the one we built
+	for (int32 layerIndex = 0; layerIndex < aLayers.Num(); layerIndex++)
+	{
+		const TArray<SVONNode>& nodes = aLayers[layerIndex];
+		for (int32 i = 0; i < nodes.Num(); i++)
+		{
+			const SVONLink& firstChild = nodes[i].myFirstChild;
+			const bool childMatches = firstChild.IsValid() ? GetFirstChild(layerIndex, i).GetNodeIndex() == firstChild.GetNodeIndex() : true;
+			const bool parentMatches = layerIndex == myTopLayer || GetParent(layerIndex, i) == nodes[i].myParent;
+
+			if (!childMatches || !parentMatches)
+			{
+				UE_LOG(UESVON, Warning, TEXT("Layer %d node %d doesn't fit the implicit octree layout, not using it"), layerIndex, i);
+				Reset();
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void SVONLinearOctree::Reset()
+{
+	myLayers.Empty();
+	myTopLayer = 0;
+	myTopCodes.Empty();
+}
+
+SVONLink SVONLinearOctree::GetParent(layerindex_t aLayer, nodeindex_t aIndex) const
+{
+	if (aLayer >= myTopLayer)
+		return SVONLink::GetInvalidLink();
+
+	return SVONLink(aLayer + 1, Select(aLayer + 1, aIndex / 8), 0);
+}
+
+mortoncode_t SVONLinearOctree::GetCode(layerindex_t aLayer, nodeindex_t aIndex) const
+{
+	// Each step up contributes the child index within its siblings
+	mortoncode_t code = 0;
+	int32 shift = 0;
+	for (layerindex_t layer = aLayer; layer < myTopLayer; layer++)
+	{
+		code |= (mortoncode_t)(aIndex & 7) << shift;
+		shift += 3;
+		aIndex = Select(layer + 1, aIndex / 8);
+	}
+
+	return (myTopCodes[aIndex] << shift) | code;
+}
+
+bool SVONLinearOctree::GetIndexForCode(layerindex_t aLayer, mortoncode_t aCode, nodeindex_t& oIndex) const
+{
+	if (aLayer > myTopLayer)
+		return false;
+
+	// Start at the top node that's an ancestor of the code, then follow children down
+	const mortoncode_t topCode = aCode >> (3 * (myTopLayer - aLayer));
+
+	// Top codes are in morton order, like every layer
+	int32 low = 0;
+	int32 high = myTopCodes.Num() - 1;
+	while (low < high)
+	{
+		const int32 mid = low + (high - low) / 2;
+		if (myTopCodes[mid] < topCode)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	if (high < 0 || myTopCodes[low] != topCode)
+		return false;
+
+	nodeindex_t index = low;
+
+	for (layerindex_t layer = myTopLayer; layer > aLayer; layer--)
+	{
+		if (!HasChildren(layer, index))
+			return false;
+
+		index = Rank(layer, index) * 8 + ((aCode >> (3 * (layer - 1 - aLayer))) & 7);
+	}
+
+	oIndex = index;
+	return true;
+}
+
+nodeindex_t SVONLinearOctree::Select(layerindex_t aLayer, int32 aRank) const
+{
+	const SVONLinearLayer& layer = myLayers[aLayer];
+
+	// Last word with no more than aRank set bits before it
+	int32 low = 0;
+	int32 high = layer.myRanks.Num() - 1;
+	while (low < high)
+	{
+		const int32 mid = low + (high - low + 1) / 2;
+		if ((int32)layer.myRanks[mid] <= aRank)
+		{
+			low = mid;
+		}
+		else
+		{
+			high = mid - 1;
+		}
+	}
+
+	// Then drop the set bits below the one we want
+	uint64 bits = layer.myChildBits[low];
+	for (int32 remaining = aRank - layer.myRanks[low]; remaining > 0 && bits; remaining--)
+	{
+		bits &= bits - 1;
+	}
+
+	if (!bits)
+		return 0;
+
+	const uint32 lowBits = (uint32)bits;
+	return low * 64 + (lowBits ? FMath::CountTrailingZeros(lowBits) : 32 + FMath::CountTrailingZeros((uint32)(bits >> 32)));
+}
+
+SIZE_T SVONLinearOctree::GetAllocatedSize() const
+{
+	SIZE_T size = myLayers.GetAllocatedSize() + myTopCodes.GetAllocatedSize();
+	for (const SVONLinearLayer& layer : myLayers)
+	{
+		size += layer.myChildBits.GetAllocatedSize() + layer.myRanks.GetAllocatedSize() + layer.myNeighbours.GetAllocatedSize();
+	}
+	return size;
+}
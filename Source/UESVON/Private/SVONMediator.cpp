@@ -6,130 +6,303 @@
 #include "SVONLink.h"
 #include "DrawDebugHelpers.h"
 
+#define SVON_BATCH_SSE2 (PLATFORM_ENABLE_VECTORINTRINSICS && !PLATFORM_ENABLE_VECTORINTRINSICS_NEON)
+
+#if SVON_BATCH_SSE2
+#include <emmintrin.h>
+#endif
+
 bool SVONMediator::GetLinkFromPosition(const FVector& aPosition, const ASVONVolume& aVolume, SVONLink& oLink)
 {
 	// Position is outside the volume, no can do
-	if (!aVolume.EncompassesPoint(aPosition))
+	FIntVector voxel;
+	if (!aVolume.GetVoxelCoordinate(aPosition, voxel))
 	{
 		return false;
 	}
 
-	FBox box = aVolume.GetComponentsBoundingBox(true);
+	// One encode at leaf voxel resolution, every layer's code is a shift of it
+	return aVolume.GetLinkForVoxel(voxel, oLink);
+}
+
+bool SVONMediator::GetLinkFromPositionCoherent(const FVector& aPosition, const ASVONVolume& aVolume, const SVONLink& aHint, SVONLink& oLink)
+{
+	FIntVector voxel;
+	if (!aVolume.GetVoxelCoordinate(aPosition, voxel))
+	{
+		return false;
+	}
+
+	// The hint may be stale, from before a regeneration or from another volume
+	if (aHint.IsValid() && aHint.GetLayerIndex() < aVolume.GetMyNumLayers() && (int32)aHint.GetNodeIndex() < aVolume.GetNumNodes(aHint.GetLayerIndex()))
+	{
+		// Still in the same node, at most a short descent into its leaf
+		if (aVolume.NodeContainsVoxel(aHint.GetLayerIndex(), aHint.GetNodeIndex(), voxel))
+		{
+			return aVolume.GetLinkForVoxelFromNode(aHint.GetLayerIndex(), aHint.GetNodeIndex(), voxel, oLink);
+		}
+
+		// Moved into a neighbouring node
+		const SVONLink* neighbours = aVolume.GetNodeNeighbours(aHint.GetLayerIndex(), aHint.GetNodeIndex());
+		for (int i = 0; i < 6; i++)
+		{
+			const SVONLink& neighbour = neighbours[i];
+			if (neighbour.IsValid() && aVolume.NodeContainsVoxel(neighbour.GetLayerIndex(), neighbour.GetNodeIndex(), voxel))
+			{
+				return aVolume.GetLinkForVoxelFromNode(neighbour.GetLayerIndex(), neighbour.GetNodeIndex(), voxel, oLink);
+			}
+		}
+	}
+
+	// Somewhere else entirely, start from the top
+	return aVolume.GetLinkForVoxel(voxel, oLink);
+}
+
+bool SVONMediator::GetNearestNavigableLink(const FVector& aPosition, const ASVONVolume& aVolume, float aMaxRadius, SVONLink& oLink, FVector& oPosition)
+{
+	FIntVector voxel;
+	if (!aVolume.GetVoxelCoordinate(aPosition, voxel))
+	{
+		return false;
+	}
+
+	// Already in free space
+	if (aVolume.GetLinkForVoxel(voxel, oLink))
+	{
+		oPosition = aPosition;
+		return true;
+	}
+
+	// Points we return are kept half a leaf voxel inside their node, so they aren't on the boundary with blocked space
+	const float halfLeafVoxel = aVolume.GetVoxelSize(0) * 0.125f;
+	float bestDistanceSq = FMath::Square(aMaxRadius);
+	bool found = false;
+
+	auto Consider = [&](const SVONLink& aLink)
+	{
+		FVector closest;
+		aVolume.GetLinkPosition(aLink, closest);
+
+		// A free node, rather than a leaf voxel. The closest point is the query clamped into it
+		if (aLink.GetLayerIndex() != 0 || !aVolume.GetNodeFirstChild(0, aLink.GetNodeIndex()).IsValid())
+		{
+			const FVector extent(aVolume.GetVoxelSize(aLink.GetLayerIndex()) * 0.5f - halfLeafVoxel);
+			closest = FBox(closest - extent, closest + extent).GetClosestPointTo(aPosition);
+		}
+
+		const float distanceSq = FVector::DistSquared(aPosition, closest);
+		if (distanceSq < bestDistanceSq)
+		{
+			bestDistanceSq = distanceSq;
+			oLink = aLink;
+			oPosition = closest;
+			found = true;
+		}
+	};
+
+	// Search spheres of doubling radius, starting at a leaf node. Anything found inside a sphere beats everything outside it,
+	// and obstacles don't matter here, so free space on the far side of a wall is found as readily as free space beside us
+	float radius = FMath::Min(aVolume.GetVoxelSize(0), aMaxRadius);
+	while (true)
+	{
+		aVolume.ForEachFreeLinkInSphere(aPosition, radius, Consider);
+
+		if ((found && bestDistanceSq <= FMath::Square(radius)) || radius >= aMaxRadius)
+			break;
+
+		radius = FMath::Min(radius * 2.f, aMaxRadius);
+	}
+
+	return found;
+}
+
+/* A batch query, keyed by its leaf resolution morton code */
+struct SVONLocateQuery
+{
+	mortoncode_t myCode;
+	int32 myIndex;
+};
+
+// Past any real code, so queries outside the volume sort to the end
+static const mortoncode_t SVONInvalidCode = ~(mortoncode_t)0;
+
+#if SVON_BATCH_SSE2
+// The libmorton magic bits spread, on two 64 bit lanes at once
+static FORCEINLINE __m128i SpreadBits3(__m128i aValue)
+{
+	aValue = _mm_and_si128(_mm_or_si128(aValue, _mm_slli_epi64(aValue, 32)), _mm_set1_epi64x(0x1f00000000ffff));
+	aValue = _mm_and_si128(_mm_or_si128(aValue, _mm_slli_epi64(aValue, 16)), _mm_set1_epi64x(0x1f0000ff0000ff));
+	aValue = _mm_and_si128(_mm_or_si128(aValue, _mm_slli_epi64(aValue, 8)), _mm_set1_epi64x(0x100f00f00f00f00f));
+	aValue = _mm_and_si128(_mm_or_si128(aValue, _mm_slli_epi64(aValue, 4)), _mm_set1_epi64x(0x10c30c30c30c30c3));
+	aValue = _mm_and_si128(_mm_or_si128(aValue, _mm_slli_epi64(aValue, 2)), _mm_set1_epi64x(0x1249249249249249));
+	return aValue;
+}
+
+static FORCEINLINE __m128i EncodeMorton(__m128i aX, __m128i aY, __m128i aZ)
+{
+	return _mm_or_si128(SpreadBits3(aX), _mm_or_si128(_mm_slli_epi64(SpreadBits3(aY), 1), _mm_slli_epi64(SpreadBits3(aZ), 2)));
+}
+#endif
+
+void SVONMediator::GetLinksFromPositions(TArrayView<const FVector> aPositions, const ASVONVolume& aVolume, TArrayView<SVONLink> oLinks)
+{
+	check(oLinks.Num() >= aPositions.Num());
+
+	const int32 numPositions = aPositions.Num();
+	const int32 numLayers = aVolume.GetMyNumLayers();
+
+	if (numLayers == 0)
+	{
+		for (int32 i = 0; i < numPositions; i++)
+		{
+			oLinks[i].SetInvalid();
+		}
+		return;
+	}
+
+	const FVector zOrigin = aVolume.GetZOrigin();
+	const float invVoxelSize = aVolume.GetInvLeafVoxelSize();
+	const float numVoxels = (float)(aVolume.GetNodesPerSide(0) * 4);
 
-	FVector origin;
-	FVector extent;
+	TArray<SVONLocateQuery> queries;
+	queries.SetNumUninitialized(numPositions);
 
-	box.GetCenterAndExtents(origin, extent);
-	// The z-order origin of the volume (where code == 0)
-	FVector zOrigin = origin - extent;
-	// The local position of the point in volume space
-	FVector localPos = aPosition - zOrigin;
+	int32 i = 0;
 
+#if SVON_BATCH_SSE2
+	const __m128 originX = _mm_set1_ps(zOrigin.X);
+	const __m128 originY = _mm_set1_ps(zOrigin.Y);
+	const __m128 originZ = _mm_set1_ps(zOrigin.Z);
+	const __m128 scale = _mm_set1_ps(invVoxelSize);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 limit = _mm_set1_ps(numVoxels);
+	const __m128i zeroInt = _mm_setzero_si128();
 
-	int layerIndex = aVolume.GetMyNumLayers() - 1;
-	nodeindex_t nodeIndex = 0;
-	while (layerIndex >= 0 && layerIndex < aVolume.GetMyNumLayers())
+	// Four positions at a time into leaf voxel coordinates, then two codes at a time
+	for (; i + 4 <= numPositions; i += 4)
 	{
-		// Get the layer and voxel size
+		const FVector& p0 = aPositions[i];
+		const FVector& p1 = aPositions[i + 1];
+		const FVector& p2 = aPositions[i + 2];
+		const FVector& p3 = aPositions[i + 3];
 
-		const TArray<SVONNode>& layer = aVolume.GetLayer(layerIndex);
-		// Calculate the XYZ coordinates
+		const __m128 x = _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(p0.X, p1.X, p2.X, p3.X), originX), scale);
+		const __m128 y = _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(p0.Y, p1.Y, p2.Y, p3.Y), originY), scale);
+		const __m128 z = _mm_mul_ps(_mm_sub_ps(_mm_setr_ps(p0.Z, p1.Z, p2.Z, p3.Z), originZ), scale);
 
+		// Coordinates are only used when they're inside on every axis, so truncating is the same as flooring
+		const __m128 insideX = _mm_and_ps(_mm_cmpge_ps(x, zero), _mm_cmplt_ps(x, limit));
+		const __m128 insideY = _mm_and_ps(_mm_cmpge_ps(y, zero), _mm_cmplt_ps(y, limit));
+		const __m128 insideZ = _mm_and_ps(_mm_cmpge_ps(z, zero), _mm_cmplt_ps(z, limit));
+		const int32 insideMask = _mm_movemask_ps(_mm_and_ps(insideX, _mm_and_ps(insideY, insideZ)));
+
+		const __m128i xInt = _mm_cvttps_epi32(x);
+		const __m128i yInt = _mm_cvttps_epi32(y);
+		const __m128i zInt = _mm_cvttps_epi32(z);
+
+		uint64 codes[4];
+		_mm_storeu_si128((__m128i*)codes, EncodeMorton(_mm_unpacklo_epi32(xInt, zeroInt), _mm_unpacklo_epi32(yInt, zeroInt), _mm_unpacklo_epi32(zInt, zeroInt)));
+		_mm_storeu_si128((__m128i*)(codes + 2), EncodeMorton(_mm_unpackhi_epi32(xInt, zeroInt), _mm_unpackhi_epi32(yInt, zeroInt), _mm_unpackhi_epi32(zInt, zeroInt)));
+
+		for (int32 lane = 0; lane < 4; lane++)
+		{
+			queries[i + lane].myCode = (insideMask & (1 << lane)) ? codes[lane] : SVONInvalidCode;
+			queries[i + lane].myIndex = i + lane;
+		}
+	}
+#endif
+
+	for (; i < numPositions; i++)
+	{
 		FIntVector voxel;
-		GetVolumeXYZ(aPosition, aVolume, layerIndex, voxel);
-		uint_fast32_t x, y, z;
-		x = voxel.X;
-		y = voxel.Y;
-		z = voxel.Z;
+		queries[i].myCode = aVolume.GetVoxelCoordinate(aPositions[i], voxel) ? morton3D_64_encode(voxel.X, voxel.Y, voxel.Z) : SVONInvalidCode;
+		queries[i].myIndex = i;
+	}
 
+	queries.Sort([](const SVONLocateQuery& A, const SVONLocateQuery& B)
+	{
+		return A.myCode < B.myCode;
+	});
+
+	// The node we went through on each layer for the previous query. In morton order, the next one usually shares most of them.
+	// Their codes are kept alongside, as reading a node's code back is a walk up its parents in the compact layout
+	TArray<nodeindex_t, TInlineAllocator<16>> pathIndices;
+	TArray<mortoncode_t, TInlineAllocator<16>> pathCodes;
+	pathIndices.Init(INDEX_NONE, numLayers);
+	pathCodes.Init(SVONInvalidCode, numLayers);
 
-		// Get the morton code we want for this layer
-		mortoncode_t code = morton3D_64_encode(x, y, z);
+	for (const SVONLocateQuery& query : queries)
+	{
+		SVONLink& link = oLinks[query.myIndex];
+		link.SetInvalid();
 
-		for (nodeindex_t j = nodeIndex; j < layer.Num(); j++)
+		if (query.myCode == SVONInvalidCode)
+			continue;
+
+		// Start from the finest node of the previous descent that also contains this code
+		layerindex_t layer = numLayers - 1;
+		nodeindex_t nodeIndex = INDEX_NONE;
+		for (int32 l = 0; l < numLayers; l++)
 		{
-			const SVONNode& node = layer[j];
-			// This is the node we are in
-			if (node.myCode == code)
+			if (pathIndices[l] != INDEX_NONE && pathCodes[l] == query.myCode >> (3 * (l + 2)))
 			{
-				// There are no child nodes, so this is our nav position
-				if (!node.myFirstChild.IsValid())// && layerIndex > 0)
-				{
-					oLink.myLayerIndex = layerIndex;
-					oLink.myNodeIndex = j;
-					oLink.mySubnodeIndex = 0;
-					return true;
-				}
+				layer = l;
+				nodeIndex = pathIndices[l];
+				break;
+			}
+		}
+
+		if (nodeIndex == INDEX_NONE && !aVolume.GetIndexForCode(layer, query.myCode >> (3 * (layer + 2)), nodeIndex))
+			continue;
 
-				// If this is a leaf node, we need to find our subnode
-				if (layerIndex == 0)
+		while (true)
+		{
+			pathIndices[layer] = nodeIndex;
+			pathCodes[layer] = query.myCode >> (3 * (layer + 2));
+			const SVONLink& firstChild = aVolume.GetNodeFirstChild(layer, nodeIndex);
+
+			if (!firstChild.IsValid())
+			{
+				link = SVONLink(layer, nodeIndex, 0);
+				break;
+			}
+
+			if (layer == 0)
+			{
+				const mortoncode_t subnode = query.myCode & 63;
+				if (!aVolume.GetLeafNode(firstChild.GetNodeIndex()).GetNode(subnode))
 				{
-					const SVONLeafNode& leaf = aVolume.GetLeafNode(node.myFirstChild.myNodeIndex);
-					// We need to calculate the node local position to get the morton code for the leaf
-					float voxelSize = aVolume.GetVoxelSize(layerIndex);
-					// The world position of the 0 node
-					FVector nodePosition;
-					aVolume.GetNodePosition(layerIndex, node.myCode, nodePosition);
-					// The morton origin of the node
-					FVector nodeOrigin = nodePosition - FVector(voxelSize * 0.5f);
-					// The requested position, relative to the node origin
-					FVector nodeLocalPos = aPosition - nodeOrigin;
-					// Now get our voxel coordinates
-					FIntVector coord;
-					coord.X = FMath::FloorToInt((nodeLocalPos.X / (voxelSize * 0.25f)));
-					coord.Y = FMath::FloorToInt((nodeLocalPos.Y / (voxelSize * 0.25f)));
-					coord.Z = FMath::FloorToInt((nodeLocalPos.Z / (voxelSize * 0.25f)));
-
-					// So our link is.....*drum roll*
-					oLink.myLayerIndex = 0; // Layer 0 (leaf)
-					oLink.myNodeIndex = j; // This index
-
-					mortoncode_t leafIndex = morton3D_64_encode(coord.X, coord.Y, coord.Z); // This morton code is our key into the 64-bit leaf node
-
-					if (leaf.GetNode(leafIndex))
-						return false;// This voxel is blocked, oops!
-
-					oLink.mySubnodeIndex = leafIndex;
-
-					return true;
+					link = SVONLink(0, nodeIndex, subnode);
 				}
-				
-				// If we've got here, the current node has a child, and isn't a leaf, so lets go down...
-				layerIndex = layer[j].myFirstChild.GetLayerIndex();
-				nodeIndex = layer[j].myFirstChild.GetNodeIndex();
-
-				break; //stop iterating this layer
+				break;
 			}
+
+			layer--;
+			nodeIndex = firstChild.GetNodeIndex() + ((query.myCode >> (3 * (layer + 2))) & 7);
 		}
 	}
-
-	return false;
 }
 
 void SVONMediator::GetVolumeXYZ(const FVector& aPosition, const ASVONVolume& aVolume, const int aLayer, FIntVector& oXYZ)
 {
-	FBox box = aVolume.GetComponentsBoundingBox(true);
+	// The local position of the point in leaf voxels
+	const FVector voxelPos = (aPosition - aVolume.GetZOrigin()) * aVolume.GetInvLeafVoxelSize();
 
-	FVector origin;
-	FVector extent;
-
-	box.GetCenterAndExtents(origin, extent);
-	// The z-order origin of the volume (where code == 0)
-	FVector zOrigin = origin - extent;
-	// The local position of the point in volume space
-	FVector localPos = aPosition - zOrigin;
-
-	int layerIndex = aLayer;
+	// A layer's nodes are 4 * 2^layer leaf voxels across
+	const int32 shift = aLayer + 2;
+	oXYZ.X = FMath::FloorToInt(voxelPos.X) >> shift;
+	oXYZ.Y = FMath::FloorToInt(voxelPos.Y) >> shift;
+	oXYZ.Z = FMath::FloorToInt(voxelPos.Z) >> shift;
+}
 
-	// Get the layer and voxel size
-	float voxelSize = aVolume.GetVoxelSize(layerIndex);
-	
-	// Calculate the XYZ coordinates
+bool SVONMediator::IsSameRegion(const FVector& aPositionA, const FVector& aPositionB, const ASVONVolume& aVolume)
+{
+	SVONLink linkA, linkB;
 
-	oXYZ.X = FMath::FloorToInt((localPos.X / voxelSize));
-	oXYZ.Y = FMath::FloorToInt((localPos.Y / voxelSize));
-	oXYZ.Z = FMath::FloorToInt((localPos.Z / voxelSize));
+	if (!GetLinkFromPosition(aPositionA, aVolume, linkA) || !GetLinkFromPosition(aPositionB, aVolume, linkB))
+	{
+		return false;
+	}
 
+	return aVolume.AreLinksConnected(linkA, linkB);
 }
-
-
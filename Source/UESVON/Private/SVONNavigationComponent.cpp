@@ -2,11 +2,12 @@
 
 #include "SVONNavigationComponent.h"
 #include "GameFramework/Actor.h"
-#include "Kismet/GameplayStatics.h"
 #include "SVONVolume.h"
+#include "SVONNavigationManager.h"
 #include "SVONLink.h"
 #include "SVONPathFinder.h"
 #include "SVONPath.h"
+#include "SVONMortonRange.h"
 #include "SVONFindPathTask.h"
 #include "DrawDebugHelpers.h"
 #include "AI/Navigation/NavigationData.h"
@@ -14,11 +15,12 @@
 
 // Sets default values for this component's properties
 USVONNavigationComponent::USVONNavigationComponent()
-	: myIsBusy(false)
+	: myCurrentNavVolume(nullptr)
+	, myIsBusy(false)
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
+	// Our nav position is kept up to date by the world's navigation manager, we only tick to draw debug points after a path request
 	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
 	myLastLocation = SVONLink(0, 0, 0);
 
 	// ...
@@ -29,6 +31,17 @@ USVONNavigationComponent::USVONNavigationComponent()
 void USVONNavigationComponent::BeginPlay()
 {
 	Super::BeginPlay();
+
+	SVONNavigationManager::Get(GetWorld()).RegisterAgent(*this);
+}
+
+void USVONNavigationComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	CancelPendingQuery();
+
+	SVONNavigationManager::Get(GetWorld()).UnregisterAgent(*this);
+
+	Super::EndPlay(EndPlayReason);
 }
 
 /** Are we inside a valid nav volume ? */
@@ -39,55 +52,22 @@ bool USVONNavigationComponent::HasNavVolume()
 
 bool USVONNavigationComponent::FindVolume()
 {
-	TArray<AActor*> navVolumes;
+	if (!GetOwner())
+		return false;
 
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), ASVONVolume::StaticClass(), navVolumes);
+	myCurrentNavVolume = SVONNavigationManager::Get(GetWorld()).FindVolume(GetOwner()->GetActorLocation());
+	return myCurrentNavVolume != nullptr;
+}
 
-	for (AActor* actor : navVolumes)
-	{
-		ASVONVolume* volume = Cast<ASVONVolume>(actor);
-		if (volume && volume->EncompassesPoint(GetOwner()->GetActorLocation()))
-		{
-			myCurrentNavVolume = volume;
-			return true;
-		}
-	}
-	return false;
+void USVONNavigationComponent::SetCurrentNavVolume(ASVONVolume* aVolume)
+{
+	myCurrentNavVolume = aVolume;
 }
 
 // Called every frame
 void USVONNavigationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-	//return;
-
-	if (!HasNavVolume())
-	{
-		FindVolume();
-	}
-	else if (myCurrentNavVolume->IsReadyForNavigation() && !myIsBusy)
-	{
-		FVector location = GetOwner()->GetActorLocation();
-		if (DebugPrintMortonCodes)
-		{
-			DebugLocalPosition(location);
-		}
-		SVONLink link = GetNavPosition(location);
-	}
-
-	int q;
-	if (myJobQueue.Dequeue(q))
-	{
-		//GetWorld()->PersistentLineBatcher->Flush();
-		if (q > 0)
-		{
-			myPointDebugIndex = 0;
-		}
-		else
-		{
-			myIsBusy = false;
-		}
-	}
 
 	if (myIsBusy && myPointDebugIndex > -1)
 	{
@@ -113,80 +93,151 @@ void USVONNavigationComponent::TickComponent(float DeltaTime, ELevelTick TickTyp
 			myIsBusy = false;
 			myPointDebugIndex = -1;
 		}
-
-
-
-
 	}
 
-
-
-
+	// Nothing left to draw, sleep until the next path request
+	if (!myIsBusy)
+	{
+		SetComponentTickEnabled(false);
+	}
 }
+
 SVONLink USVONNavigationComponent::GetNavPosition(FVector& aPosition)
 {
 	SVONLink navLink;
 	if (HasNavVolume())
 	{
-		// Get the nav link from our volume
-		SVONMediator::GetLinkFromPosition(GetOwner()->GetActorLocation(), *myCurrentNavVolume, navLink);
+		// Get the nav link from our volume, we've usually only moved a little since last time
+		SVONMediator::GetLinkFromPositionCoherent(GetOwner()->GetActorLocation(), *myCurrentNavVolume, myLastLocation, navLink);
 
-		if (navLink == myLastLocation)
-			return navLink;
+		UpdateNavPosition(GetOwner()->GetActorLocation(), navLink);
+	}
+	return navLink;
+}
+
+void USVONNavigationComponent::UpdateNavPosition(const FVector& aPosition, const SVONLink& aLink)
+{
+	if (DebugPrintMortonCodes)
+	{
+		FVector position = aPosition;
+		DebugLocalPosition(position);
+	}
 
-		myLastLocation = navLink;
+	if (aLink == myLastLocation)
+		return;
 
-		FVector targetPos = GetOwner()->GetActorLocation() + (GetOwner()->GetActorForwardVector() * 10000.f);
+	myLastLocation = aLink;
 
-		if (DebugPrintCurrentPosition)
-		{
-			const SVONNode& currentNode = myCurrentNavVolume->GetNode(navLink);
-			FVector currentNodePosition;
+	if (DebugPrintCurrentPosition && myCurrentNavVolume)
+	{
+		FVector currentNodePosition;
 
-			bool isValid = myCurrentNavVolume->GetLinkPosition(navLink, currentNodePosition);
+		bool isValid = myCurrentNavVolume->GetLinkPosition(aLink, currentNodePosition);
 
-			DrawDebugLine(GetWorld(), GetOwner()->GetActorLocation(), currentNodePosition, isValid ? FColor::Green : FColor::Red, false, -1.f, 0, 10.f);
-			DrawDebugString(GetWorld(), GetOwner()->GetActorLocation() + FVector(0.f, 0.f, -50.f), navLink.ToString(), NULL, FColor::Yellow, 0.01f);
-		}
-		
+		DrawDebugLine(GetWorld(), aPosition, currentNodePosition, isValid ? FColor::Green : FColor::Red, false, -1.f, 0, 10.f);
+		DrawDebugString(GetWorld(), aPosition + FVector(0.f, 0.f, -50.f), aLink.ToString(), NULL, FColor::Yellow, 0.01f);
 	}
-	return navLink;
 }
 
-bool USVONNavigationComponent::FindPathAsync(const FVector& aStartPosition, const FVector& aTargetPosition, FNavPathSharedPtr* oNavPath)
+FSVONPathQueryHandle USVONNavigationComponent::FindPathAsync(const FVector& aStartPosition, const FVector& aTargetPosition, const FSVONPathQueryComplete& aOnComplete)
 {
-	UE_LOG(UESVON, Display, TEXT("Finding path from %s and %s"), *GetOwner()->GetActorLocation().ToString(), *aTargetPosition.ToString());
+	UE_LOG(UESVON, Display, TEXT("Finding path from %s and %s"), *aStartPosition.ToString(), *aTargetPosition.ToString());
 
 	SVONLink startNavLink;
 	SVONLink targetNavLink;
 	if (HasNavVolume())
 	{
 		// Get the nav link from our volume
-		if (!SVONMediator::GetLinkFromPosition(GetOwner()->GetActorLocation(), *myCurrentNavVolume, startNavLink))
+		if (!SVONMediator::GetLinkFromPosition(aStartPosition, *myCurrentNavVolume, startNavLink))
 		{
 			UE_LOG(UESVON, Display, TEXT("Path finder failed to find start nav link"));
-			return false;
+			return FSVONPathQueryHandle();
 		}
 
-		if (!SVONMediator::GetLinkFromPosition(aTargetPosition, *myCurrentNavVolume, targetNavLink))
+		FVector targetPosition;
+		if (!GetTargetNavLink(aTargetPosition, targetNavLink, targetPosition))
 		{
 			UE_LOG(UESVON, Display, TEXT("Path finder failed to find target nav link"));
-			return false;
+			return FSVONPathQueryHandle();
 		}
 
+		// Only one query in flight per component, the latest request wins
+		CancelPendingQuery();
+
 		myDebugPoints.Empty();
 		myPointDebugIndex = -1;
 
-		(new FAutoDeleteAsyncTask<FSVONFindPathTask>(*myCurrentNavVolume, GetWorld(), startNavLink, targetNavLink, oNavPath, myJobQueue, myDebugPoints))->StartBackgroundTask();
+		SVONPathQueryStatePtr state = MakeShareable(new SVONPathQueryState());
+		state->myStart = startNavLink;
+		state->myTarget = targetNavLink;
+		state->myDebugOpenNodes = DebugDrawOpenNodes;
+		state->mySettings = GetPathFinderSettings();
+		state->myPartialIterations = PartialPathIterations;
+		state->myResult.myTargetPosition = targetPosition;
+
+		// Wrap the caller's delegate so we can pick up our debug points, but only if we're still around
+		TWeakObjectPtr<USVONNavigationComponent> weakThis(this);
+		state->myOnComplete = FSVONPathQueryComplete::CreateLambda([weakThis, aOnComplete](const SVONPathQueryResult& aResult)
+		{
+			if (weakThis.IsValid() && !aResult.myIsPartial)
+			{
+				weakThis->myCurrentPath = aResult.myPath;
+				weakThis->myDebugPoints = aResult.myDebugPoints;
+				weakThis->myPointDebugIndex = aResult.myResult > 0 ? 0 : -1;
+				weakThis->myIsBusy = aResult.myResult > 0;
+				weakThis->SetComponentTickEnabled(weakThis->myIsBusy);
+			}
 
-		myIsBusy = true;
+			aOnComplete.ExecuteIfBound(aResult);
+		});
 
-		return true;
+		(new FAutoDeleteAsyncTask<FSVONFindPathTask>(*myCurrentNavVolume, state))->StartBackgroundTask();
 
+		myPendingQuery = FSVONPathQueryHandle(state);
 
+		return myPendingQuery;
 	}
 
-	return false;
+	return FSVONPathQueryHandle();
+}
+
+void USVONNavigationComponent::CancelPendingQuery()
+{
+	myPendingQuery.Cancel();
+}
+
+bool USVONNavigationComponent::GetTargetNavLink(const FVector& aTargetPosition, SVONLink& oLink, FVector& oTargetPosition) const
+{
+	oTargetPosition = aTargetPosition;
+
+	if (SVONMediator::GetLinkFromPosition(aTargetPosition, *myCurrentNavVolume, oLink))
+		return true;
+
+	if (TargetSnapRadius <= 0.f)
+		return false;
+
+	return SVONMediator::GetNearestNavigableLink(aTargetPosition, *myCurrentNavVolume, TargetSnapRadius, oLink, oTargetPosition);
+}
+
+SVONPathFinderSettings USVONNavigationComponent::GetPathFinderSettings() const
+{
+	SVONPathFinderSettings settings;
+	settings.myMaxIterations = MaxSearchIterations;
+	settings.myMaxMilliseconds = MaxSearchMilliseconds;
+	settings.myUseHierarchicalSearch = UseHierarchicalSearch;
+	settings.myCorridorLayer = CorridorLayer;
+	settings.myUseAbstractGraph = UseAbstractGraph;
+	settings.myUseLandmarkHeuristic = UseLandmarkHeuristic;
+	settings.myUseBidirectionalSearch = UseBidirectionalSearch;
+	settings.myPathCostType = PathCostType;
+	settings.myHeuristicWeight = HeuristicWeight;
+	settings.myUseJumpPointSearch = UseJumpPointSearch;
+	settings.myUseThetaStar = UseThetaStar;
+	settings.myStringPullPath = StringPullPath;
+	settings.myResamplePath = ResamplePath;
+	settings.myResampleSpacing = ResampleSpacing;
+	settings.myRemoveCollinearPoints = RemoveCollinearPoints;
+	return settings;
 }
 
 bool USVONNavigationComponent::FindPathImmediate(const FVector& aStartPosition, const FVector& aTargetPosition, FNavPathSharedPtr* oNavPath)
@@ -206,7 +257,9 @@ bool USVONNavigationComponent::FindPathImmediate(const FVector& aStartPosition,
 
 
 
-		if (!SVONMediator::GetLinkFromPosition(aTargetPosition, *myCurrentNavVolume, targetNavLink))
+		// A target on geometry is moved to the nearest free point, rather than failing the whole request
+		FVector targetPosition;
+		if (!GetTargetNavLink(aTargetPosition, targetNavLink, targetPosition))
 		{
 			UE_LOG(UESVON, Display, TEXT("Path finder failed to find target nav link"));
 			return false;
@@ -227,15 +280,25 @@ bool USVONNavigationComponent::FindPathImmediate(const FVector& aStartPosition,
 
 		TArray<FVector> debugOpenPoints;
 
-		SVONPathFinder pathFinder(*myCurrentNavVolume, true, GetWorld(), debugOpenPoints);
+		SVONPathFinder pathFinder(*myCurrentNavVolume, true, GetWorld(), debugOpenPoints, GetPathFinderSettings());
 
 		int result = pathFinder.FindPath(startNavLink, targetNavLink, oNavPath);
 
-		// Add the target point, as the path only includes octree node positions
-		oNavPath->Get()->GetPathPoints().Add(aTargetPosition);
+		myCurrentPath = pathFinder.GetPath();
+
+		// Add the target point, as the path only includes octree node positions. A partial path stops short of it
+		if (pathFinder.GetStatus() == ESVONPathStatus::Partial)
+		{
+			path->SetIsPartial(true);
+		}
+		else
+		{
+			oNavPath->Get()->GetPathPoints().Add(targetPosition);
+		}
 
 		myIsBusy = true;
 		myPointDebugIndex = 0;
+		SetComponentTickEnabled(true);
 
 
 		path->MarkReady();
@@ -247,6 +310,73 @@ bool USVONNavigationComponent::FindPathImmediate(const FVector& aStartPosition,
 	return false;
 }
 
+bool USVONNavigationComponent::FindPathScheduled(const FVector& aStartPosition, const FVector& aTargetPosition, ESVONPathPriority aPriority, FNavPathSharedPtr aNavPath)
+{
+	SVONLink startNavLink;
+	SVONLink targetNavLink;
+	if (HasNavVolume())
+	{
+		// Get the nav link from our volume
+		if (!SVONMediator::GetLinkFromPosition(aStartPosition, *myCurrentNavVolume, startNavLink))
+		{
+			UE_LOG(UESVON, Display, TEXT("Path finder failed to find start nav link"));
+			return false;
+		}
+
+		FVector targetPosition;
+		if (!GetTargetNavLink(aTargetPosition, targetNavLink, targetPosition))
+		{
+			UE_LOG(UESVON, Display, TEXT("Path finder failed to find target nav link"));
+			return false;
+		}
+
+		if (!aNavPath.IsValid())
+		{
+			UE_LOG(UESVON, Display, TEXT("Nav path data invalid"));
+			return false;
+		}
+
+		aNavPath->ResetForRepath();
+
+		TWeakObjectPtr<USVONNavigationComponent> weakThis(this);
+
+		FSVONScheduledPathComplete onComplete = FSVONScheduledPathComplete::CreateLambda([weakThis, aNavPath, targetPosition](ESVONPathStatus aStatus, const SVONPath& aPath)
+		{
+			if (aStatus != ESVONPathStatus::Failed)
+			{
+				for (const FVector& point : aPath.GetPoints())
+				{
+					aNavPath->GetPathPoints().Add(point);
+				}
+
+				// Add the target point, as the path only includes octree node positions. A partial path stops short of it
+				if (aStatus == ESVONPathStatus::Complete)
+				{
+					aNavPath->GetPathPoints().Add(targetPosition);
+				}
+			}
+
+			aNavPath->SetIsPartial(aStatus == ESVONPathStatus::Partial);
+
+			if (weakThis.IsValid())
+			{
+				weakThis->myCurrentPath = aPath;
+			}
+
+			aNavPath->MarkReady();
+		});
+
+		return SVONPathScheduler::Get(GetWorld()).RequestPath(*myCurrentNavVolume, startNavLink, targetNavLink, aPriority, GetPathFinderSettings(), onComplete);
+	}
+
+	return false;
+}
+
+bool USVONNavigationComponent::IsCurrentPathInvalidatedBy(const TArray<SVONMortonRange>& aChangedRanges) const
+{
+	return myCurrentPath.IsInvalidatedBy(aChangedRanges);
+}
+
 void USVONNavigationComponent::DebugLocalPosition(FVector& aPosition) 
 {
 
@@ -0,0 +1,201 @@
+#include "SVONNavigationManager.h"
+#include "SVONVolume.h"
+#include "SVONMediator.h"
+#include "SVONNavigationComponent.h"
+#include "GameFramework/Actor.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("SVONNavigationManager Tick"), STAT_SVONNavigationManagerTick, STATGROUP_AI);
+
+// Size of a volume grid cell. Volumes covering more cells than the limit skip the grid
+static const float SVONVolumeGridCellSize = 10000.f;
+static const int32 SVONMaxVolumeGridCells = 512;
+
+TMap<TWeakObjectPtr<UWorld>, TSharedPtr<SVONNavigationManager>> SVONNavigationManager::ourManagers;
+
+SVONNavigationManager::SVONNavigationManager(UWorld* aWorld)
+	: myWorld(aWorld)
+{
+}
+
+SVONNavigationManager& SVONNavigationManager::Get(UWorld* aWorld)
+{
+	static bool registeredCleanup = false;
+	if (!registeredCleanup)
+	{
+		FWorldDelegates::OnWorldCleanup.AddStatic(&SVONNavigationManager::OnWorldCleanup);
+		registeredCleanup = true;
+	}
+
+	TSharedPtr<SVONNavigationManager>& manager = ourManagers.FindOrAdd(aWorld);
+	if (!manager.IsValid())
+	{
+		manager = MakeShareable(new SVONNavigationManager(aWorld));
+	}
+	return *manager;
+}
+
+void SVONNavigationManager::OnWorldCleanup(UWorld* aWorld, bool aSessionEnded, bool aCleanupResources)
+{
+	ourManagers.Remove(aWorld);
+}
+
+TStatId SVONNavigationManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(SVONNavigationManager, STATGROUP_Tickables);
+}
+
+void SVONNavigationManager::RegisterVolume(ASVONVolume& aVolume)
+{
+	SVONVolumeEntry* entry = myVolumes.FindByPredicate([&](const SVONVolumeEntry& aEntry) { return aEntry.myVolume.Get() == &aVolume; });
+	if (!entry)
+	{
+		entry = &myVolumes[myVolumes.AddDefaulted()];
+		entry->myVolume = &aVolume;
+	}
+
+	entry->myBounds = aVolume.GetComponentsBoundingBox(true);
+
+	RebuildVolumeGrid();
+}
+
+void SVONNavigationManager::UnregisterVolume(ASVONVolume& aVolume)
+{
+	myVolumes.RemoveAll([&](const SVONVolumeEntry& aEntry) { return !aEntry.myVolume.IsValid() || aEntry.myVolume.Get() == &aVolume; });
+	myBatches.Remove(TWeakObjectPtr<ASVONVolume>(&aVolume));
+
+	RebuildVolumeGrid();
+}
+
+FIntVector SVONNavigationManager::GetGridCell(const FVector& aPosition) const
+{
+	return FIntVector(
+		FMath::FloorToInt(aPosition.X / SVONVolumeGridCellSize),
+		FMath::FloorToInt(aPosition.Y / SVONVolumeGridCellSize),
+		FMath::FloorToInt(aPosition.Z / SVONVolumeGridCellSize));
+}
+
+void SVONNavigationManager::RebuildVolumeGrid()
+{
+	myVolumeGrid.Reset();
+	myLargeVolumes.Reset();
+
+	for (int32 i = 0; i < myVolumes.Num(); i++)
+	{
+		SVONVolumeEntry& entry = myVolumes[i];
+
+		const FIntVector minCell = GetGridCell(entry.myBounds.Min);
+		const FIntVector maxCell = GetGridCell(entry.myBounds.Max);
+		const FIntVector numCells = maxCell - minCell + FIntVector(1);
+
+		entry.myIsLarge = (int64)numCells.X * numCells.Y * numCells.Z > SVONMaxVolumeGridCells;
+		if (entry.myIsLarge)
+		{
+			myLargeVolumes.Add(i);
+			continue;
+		}
+
+		for (int32 x = minCell.X; x <= maxCell.X; x++)
+		for (int32 y = minCell.Y; y <= maxCell.Y; y++)
+		for (int32 z = minCell.Z; z <= maxCell.Z; z++)
+		{
+			myVolumeGrid.FindOrAdd(FIntVector(x, y, z)).Add(i);
+		}
+	}
+}
+
+ASVONVolume* SVONNavigationManager::FindVolume(const FVector& aPosition) const
+{
+	if (const TArray<int32>* cell = myVolumeGrid.Find(GetGridCell(aPosition)))
+	{
+		for (int32 index : *cell)
+		{
+			const SVONVolumeEntry& entry = myVolumes[index];
+			if (entry.myVolume.IsValid() && entry.myBounds.IsInside(aPosition))
+			{
+				return entry.myVolume.Get();
+			}
+		}
+	}
+
+	for (int32 index : myLargeVolumes)
+	{
+		const SVONVolumeEntry& entry = myVolumes[index];
+		if (entry.myVolume.IsValid() && entry.myBounds.IsInside(aPosition))
+		{
+			return entry.myVolume.Get();
+		}
+	}
+
+	return nullptr;
+}
+
+void SVONNavigationManager::RegisterAgent(USVONNavigationComponent& aAgent)
+{
+	myAgents.AddUnique(&aAgent);
+}
+
+void SVONNavigationManager::UnregisterAgent(USVONNavigationComponent& aAgent)
+{
+	myAgents.RemoveSingleSwap(&aAgent);
+}
+
+void SVONNavigationManager::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SVONNavigationManagerTick);
+
+	for (TPair<TWeakObjectPtr<ASVONVolume>, SVONAgentBatch>& batch : myBatches)
+	{
+		batch.Value.myAgents.Reset();
+		batch.Value.myPositions.Reset();
+	}
+
+	// Sort the agents into the volumes they're in
+	for (int32 i = myAgents.Num() - 1; i >= 0; i--)
+	{
+		USVONNavigationComponent* agent = myAgents[i].Get();
+		if (!agent || !agent->GetOwner())
+		{
+			myAgents.RemoveAtSwap(i);
+			continue;
+		}
+
+		const FVector position = agent->GetOwner()->GetActorLocation();
+
+		ASVONVolume* volume = FindVolume(position);
+		agent->SetCurrentNavVolume(volume);
+
+		if (!volume || !volume->IsReadyForNavigation())
+			continue;
+
+		SVONAgentBatch& batch = myBatches.FindOrAdd(volume);
+		batch.myAgents.Add(agent);
+		batch.myPositions.Add(position);
+	}
+
+	// One batched lookup per volume
+	for (TPair<TWeakObjectPtr<ASVONVolume>, SVONAgentBatch>& pair : myBatches)
+	{
+		SVONAgentBatch& batch = pair.Value;
+		const ASVONVolume* volume = pair.Key.Get();
+		if (!volume || batch.myAgents.Num() == 0)
+			continue;
+
+		batch.myLinks.SetNum(batch.myPositions.Num());
+		SVONMediator::GetLinksFromPositions(batch.myPositions, *volume, batch.myLinks);
+
+		for (int32 i = 0; i < batch.myAgents.Num(); i++)
+		{
+			batch.myAgents[i]->UpdateNavPosition(batch.myPositions[i], batch.myLinks[i]);
+		}
+	}
+
+	// Drop batches for volumes that are gone, or that nobody is in any more
+	for (auto it = myBatches.CreateIterator(); it; ++it)
+	{
+		if (!it.Key().IsValid() || it.Value().myAgents.Num() == 0)
+		{
+			it.RemoveCurrent();
+		}
+	}
+}
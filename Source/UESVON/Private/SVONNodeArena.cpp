@@ -0,0 +1,63 @@
+#include "SVONNodeArena.h"
+#include "SVONNode.h"
+
+static const int32 SVONArenaAlignment = 64;
+
+void SVONNodeArena::Build(const TArray<TArray<SVONNode>>& aLayers)
+{
+	Reset();
+
+	myLayerOffsets.Reserve(aLayers.Num() + 1);
+
+	int32 numNodes = 0;
+	for (const TArray<SVONNode>& layer : aLayers)
+	{
+		myLayerOffsets.Add(numNodes);
+		numNodes += layer.Num();
+	}
+	myLayerOffsets.Add(numNodes);
+
+	// Hot arrays first
+	int32 size = 0;
+	myFirstChildrenOffset = size;
+	size = Align(size + numNodes * (int32)sizeof(SVONLink), SVONArenaAlignment);
+	myNeighboursOffset = size;
+	size = Align(size + numNodes * 6 * (int32)sizeof(SVONLink), SVONArenaAlignment);
+	myCodesOffset = size;
+	size = Align(size + numNodes * (int32)sizeof(mortoncode_t), SVONArenaAlignment);
+	myParentsOffset = size;
+	size = Align(size + numNodes * (int32)sizeof(SVONLink), SVONArenaAlignment);
+
+	myBuffer.SetNumUninitialized(size);
+
+	mortoncode_t* codes = reinterpret_cast<mortoncode_t*>(myBuffer.GetData() + myCodesOffset);
+	SVONLink* parents = reinterpret_cast<SVONLink*>(myBuffer.GetData() + myParentsOffset);
+	SVONLink* firstChildren = reinterpret_cast<SVONLink*>(myBuffer.GetData() + myFirstChildrenOffset);
+	SVONLink* neighbours = reinterpret_cast<SVONLink*>(myBuffer.GetData() + myNeighboursOffset);
+
+	int32 index = 0;
+	for (const TArray<SVONNode>& layer : aLayers)
+	{
+		for (const SVONNode& node : layer)
+		{
+			codes[index] = node.myCode;
+			parents[index] = node.myParent;
+			firstChildren[index] = node.myFirstChild;
+			for (int32 i = 0; i < 6; i++)
+			{
+				neighbours[index * 6 + i] = node.myNeighbours[i];
+			}
+			index++;
+		}
+	}
+}
+
+void SVONNodeArena::Reset()
+{
+	myBuffer.Empty();
+	myLayerOffsets.Empty();
+	myFirstChildrenOffset = 0;
+	myNeighboursOffset = 0;
+	myCodesOffset = 0;
+	myParentsOffset = 0;
+}
@@ -1,14 +1,109 @@
-
 #include "SVONPath.h"
+#include "SVONMortonRange.h"
+#include "DrawDebugHelpers.h"
 
 void SVONPath::AddPoint(const FVector& aPoint)
 {
 	myPoints.Add(aPoint);
 }
 
+void SVONPath::AddLink(const SVONLink& aLink, mortoncode_t aCode)
+{
+	myLinks.Add(aLink);
+	myLinkCodes.Add(aCode);
+}
+
 void SVONPath::ResetPath()
 {
 	myPoints.Empty();
+	myLinks.Empty();
+	myLinkCodes.Empty();
+}
+
+bool SVONPath::IsInvalidatedBy(const TArray<SVONMortonRange>& aChangedRanges) const
+{
+	if (aChangedRanges.Num() == 0 || myLinks.Num() == 0)
+	{
+		return false;
+	}
+
+	// Ranges sorted by layer then min code, with the running max of the max codes so overlapping ranges still binary search
+	TArray<SVONMortonRange> ranges(aChangedRanges);
+	ranges.Sort([](const SVONMortonRange& A, const SVONMortonRange& B)
+	{
+		return A.myLayer != B.myLayer ? A.myLayer < B.myLayer : A.myMin < B.myMin;
+	});
+
+	TArray<mortoncode_t> runningMax;
+	runningMax.SetNumUninitialized(ranges.Num());
+	for (int32 i = 0; i < ranges.Num(); i++)
+	{
+		const bool newLayer = i == 0 || ranges[i].myLayer != ranges[i - 1].myLayer;
+		runningMax[i] = newLayer ? ranges[i].myMax : FMath::Max(runningMax[i - 1], ranges[i].myMax);
+	}
+
+	for (int32 first = 0; first < ranges.Num();)
+	{
+		const layerindex_t rangeLayer = ranges[first].myLayer;
+		int32 end = first + 1;
+		while (end < ranges.Num() && ranges[end].myLayer == rangeLayer)
+		{
+			end++;
+		}
+
+		for (int32 i = 0; i < myLinks.Num(); i++)
+		{
+			// The codes this link covers on the ranges' layer, see SVONMortonRange::Overlaps
+			const layerindex_t layer = myLinks[i].GetLayerIndex();
+			mortoncode_t low, high;
+			if (layer >= rangeLayer)
+			{
+				const uint32 shift = 3 * (layer - rangeLayer);
+				low = myLinkCodes[i] << shift;
+				high = ((myLinkCodes[i] + 1) << shift) - 1;
+			}
+			else
+			{
+				low = high = myLinkCodes[i] >> (3 * (rangeLayer - layer));
+			}
+
+			// Last range starting at or before our high code, anything before it that reaches our low code overlaps
+			int32 lo = first, hi = end;
+			while (lo < hi)
+			{
+				const int32 mid = (lo + hi) / 2;
+				if (ranges[mid].myMin <= high)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+
+			if (lo > first && runningMax[lo - 1] >= low)
+			{
+				return true;
+			}
+		}
+
+		first = end;
+	}
+
+	return false;
+}
+
+bool SVONPath::IsInvalidatedBy(const TArray<TBitArray<>>& aChangedNodes) const
+{
+	for (const SVONLink& link : myLinks)
+	{
+		const int32 layer = link.GetLayerIndex();
+		const int32 node = link.GetNodeIndex();
+
+		if (layer < aChangedNodes.Num() && node < aChangedNodes[layer].Num() && aChangedNodes[layer][node])
+		{
+			return true;
+		}
+	}
+
+	return false;
 }
 
 void SVONPath::DebugDraw(UWorld* aWorld)
@@ -31,4 +126,3 @@ void SVONPath::DebugDraw(UWorld* aWorld)
 		}
 	}
 }
-
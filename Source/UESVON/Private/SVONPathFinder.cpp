@@ -1,28 +1,150 @@
 #include "SVONPathFinder.h"
 #include "SVONLink.h"
+#include "SVONVolume.h"
 #include "AI/Navigation/NavigationData.h"
+#include "Async/ParallelFor.h"
+#include "Algo/Reverse.h"
 
 
 int SVONPathFinder::FindPath(const SVONLink& aStart, const SVONLink& aGoal, FNavPathSharedPtr* oPath)
 {
-	myOpenSet.Empty();
-	myClosedSet.Empty();
-	myCameFrom.Empty();
-	myFScore.Empty();
-	myGScore.Empty();
-	myCurrent = SVONLink();
+	myStatus = ESVONPathStatus::Failed;
+	myNumIterations = 0;
+	myPath.ResetPath();
+
+	// One budget for the whole query, however many searches it takes
+	mySearchStartTime = FPlatformTime::Seconds();
+
+	// Different free-space regions, no search needed to know this will fail
+	if (!myVolume.AreLinksConnected(aStart, aGoal))
+	{
+		UE_LOG(UESVON, Verbose, TEXT("Pathfinding failed, start and target are not connected"));
+		return 0;
+	}
+
+	// Between clusters, the abstract graph gets us there with two small local searches
+	if (mySettings.myUseAbstractGraph && myVolume.GetAbstractGraph().IsBuilt())
+	{
+		TArray<SVONLink> links;
+		if (myVolume.GetAbstractGraph().FindPath(myVolume, aStart, aGoal, links))
+		{
+			myStatus = ESVONPathStatus::Complete;
+			BuildPathFromLinks(links, oPath);
+			UE_LOG(UESVON, Verbose, TEXT("Pathfinding complete through abstract graph"));
+			return 1;
+		}
+	}
+
+	myStart = aStart;
 	myGoal = aGoal;
+	myUseCorridor = mySettings.myUseHierarchicalSearch && BuildCorridor(aStart, aGoal);
+
+	StartSearch();
+	return ContinueSearch(oPath);
+}
+
+int SVONPathFinder::ResumePath(FNavPathSharedPtr* oPath)
+{
+	if (myStatus != ESVONPathStatus::Partial)
+	{
+		return myStatus == ESVONPathStatus::Complete ? 1 : 0;
+	}
+
+	myNumIterations = 0;
+	mySearchStartTime = FPlatformTime::Seconds();
+	myPath.ResetPath();
+
+	return ContinueSearch(oPath);
+}
+
+void SVONPathFinder::SetSearchLimits(int32 aMaxIterations, float aMaxMilliseconds)
+{
+	mySettings.myMaxIterations = aMaxIterations;
+	mySettings.myMaxMilliseconds = aMaxMilliseconds;
+}
+
+void SVONPathFinder::StartSearch()
+{
+	if (mySettings.myUseBidirectionalSearch)
+	{
+		StartSearchBidirectional();
+		return;
+	}
+
+	// Theta* reparents links past the cell they were jumped from, which jump expansion can't follow
+	myUseJumps = mySettings.myUseJumpPointSearch && !mySettings.myUseThetaStar;
+	StartSearchUnidirectional();
+}
+
+int SVONPathFinder::ContinueSearch(FNavPathSharedPtr* oPath)
+{
+	int result = RunSearch(oPath);
+
+	// The corridor went through a partially blocked cell we couldn't actually get through, so search everything
+	if (myUseCorridor && myStatus == ESVONPathStatus::Failed)
+	{
+		UE_LOG(UESVON, Verbose, TEXT("Pathfinding failed inside corridor, searching the full octree"));
+		myUseCorridor = false;
+		StartSearch();
+		result = RunSearch(oPath);
+	}
 
+	return result;
+}
 
-	myOpenSet.Add(aStart);
-	myCameFrom.Add(aStart, aStart);
-	myGScore.Add(aStart, 0);
-	myFScore.Add(aStart, HeuristicScore(aStart, myGoal)); // Distance to target
+int SVONPathFinder::RunSearch(FNavPathSharedPtr* oPath)
+{
+	if (mySettings.myUseBidirectionalSearch)
+	{
+		return SearchPathBidirectional(oPath);
+	}
 
-	int numIterations = 0;
+	return SearchPath(oPath);
+}
+
+void SVONPathFinder::StartSearchUnidirectional()
+{
+	// Reset rather than Empty, so repeated queries reuse our allocations
+	myOpenSet.Reset();
+	myClosedSet.Reset();
+	myCameFrom.Reset();
+	myFScore.Reset();
+	myGScore.Reset();
+	myJumpDirections.Reset();
+	myCurrent = SVONLink();
+	myBestLink = myStart;
+	myBestHeuristic = FLT_MAX;
+
+	myGoalLandmarkDistances.Reset();
+	if (mySettings.myUseLandmarkHeuristic)
+	{
+		const int32 goalIndex = myVolume.GetNavIndex(myGoal);
+		for (int32 i = 0; goalIndex != INDEX_NONE && i < myVolume.GetNumLandmarks(); i++)
+		{
+			myGoalLandmarkDistances.Add(myVolume.GetLandmarkDistance(i, goalIndex));
+		}
+	}
+
+	myOpenSet.Add(myStart);
+	myCameFrom.Add(myStart, myStart);
+	myGScore.Add(myStart, 0);
+	myFScore.Add(myStart, HeuristicScore(myStart, myGoal)); // Distance to target
+}
+
+int SVONPathFinder::SearchPath(FNavPathSharedPtr* oPath)
+{
+	myStatus = ESVONPathStatus::Failed;
 
 	while (myOpenSet.Num() > 0)
 	{
+		// Out of budget, give back the best we've got
+		if (IsOutOfBudget())
+		{
+			myStatus = ESVONPathStatus::Partial;
+			BuildPath(myCameFrom, myBestLink, oPath);
+			UE_LOG(UESVON, Verbose, TEXT("Pathfinding hit its search limit, iterations : %i"), myNumIterations);
+			return 0;
+		}
 		
 		float lowestScore = FLT_MAX;
 		for (SVONLink& link : myOpenSet)
@@ -39,35 +161,273 @@ int SVONPathFinder::FindPath(const SVONLink& aStart, const SVONLink& aGoal, FNav
 
 		if (myCurrent == myGoal)
 		{
+			myStatus = ESVONPathStatus::Complete;
 			BuildPath(myCameFrom, myCurrent, oPath);
-			UE_LOG(UESVON, Display, TEXT("Pathfinding complete, iterations : %i"), numIterations);
+			UE_LOG(UESVON, Verbose, TEXT("Pathfinding complete, iterations : %i"), myNumIterations);
 			return 1;
 		}
 
-		const SVONNode& currentNode = myVolume.GetNode(myCurrent);
+		// Track the expanded node closest to the goal, in case we have to settle for a partial path
+		const float heuristic = myFScore[myCurrent] - myGScore[myCurrent];
+		if (heuristic < myBestHeuristic)
+		{
+			myBestHeuristic = heuristic;
+			myBestLink = myCurrent;
+		}
+
+		const bool isLeafSubnode = IsLeafSubnode(myCurrent);
 
-		TArray<SVONLink> neighbours;
+		myNeighbours.Reset();
+		myJumpDirection = -1;
 
-		if (myCurrent.GetLayerIndex() == 0 && currentNode.myFirstChild.IsValid())
+		if (myUseJumps && isLeafSubnode)
 		{
-			
-			myVolume.GetLeafNeighbours(myCurrent, neighbours);
+			ProcessJumpSuccessors();
 		}
 		else
 		{
-			myVolume.GetNeighbours(myCurrent, neighbours);
+			if (isLeafSubnode)
+			{
+				myVolume.GetLeafNeighbours(myCurrent, myNeighbours);
+			}
+			else
+			{
+				myVolume.GetNeighbours(myCurrent, myNeighbours);
+			}
+
+			for (const SVONLink& neighbour : myNeighbours)
+			{
+				ProcessLink(neighbour);
+			}
 		}
 
-		for (const SVONLink& neighbour : neighbours)
+		myNumIterations++;
+	}
+
+	UE_LOG(UESVON, Verbose, TEXT("Pathfinding failed, iterations : %i"), myNumIterations);
+	return 0;
+}
+
+static bool IsLowerFScore(const SVONSearchEntry& A, const SVONSearchEntry& B)
+{
+	return A.myFScore < B.myFScore;
+}
+
+void SVONPathFinder::StartSearchBidirectional()
+{
+	myForwardOpen.Reset();
+	myClosedSet.Reset();
+	myCameFrom.Reset();
+	myGScore.Reset();
+	myBackwardOpen.Reset();
+	myBackwardClosedSet.Reset();
+	myBackwardCameFrom.Reset();
+	myBackwardGScore.Reset();
+	myBestLink = myStart;
+	myBestHeuristic = FLT_MAX;
+
+	// Straight line distance times the least a step can cost per unit of distance never overestimates a step, so it's consistent
+	// on both sides and the stopping test is exact. A heuristic weight above 1 gives that up, for paths at most that much longer
+	const float leafNodeSize = myVolume.GetVoxelSize(0);
+	const float largestStep = myVolume.GetVoxelSize(FMath::Max<int32>(myVolume.GetMyNumLayers() - 1, 0));
+	switch (mySettings.myPathCostType)
+	{
+	// A step costs one leaf node width per round(distance / step size), and that's never under distance / (1.5 * step size)
+	case ESVONPathCostType::UnitCost:
+		myBidirectionalHeuristicScale = leafNodeSize / (1.5f * largestStep);
+		break;
+	// Cheapest in the biggest nodes
+	case ESVONPathCostType::SizeScaled:
+		myBidirectionalHeuristicScale = leafNodeSize / largestStep;
+		break;
+	default:
+		myBidirectionalHeuristicScale = 1.f;
+		break;
+	}
+	myBidirectionalHeuristicScale *= mySettings.myHeuristicWeight;
+
+	// The landmark tables are distances over the nav neighbour graph, which this search doesn't walk, so they aren't a safe bound here
+	if (mySettings.myUseLandmarkHeuristic)
+	{
+		UE_LOG(UESVON, Verbose, TEXT("Bidirectional pathfinding doesn't use the landmark heuristic, using straight line distance"));
+	}
+
+	myForwardOpen.HeapPush({ myStart, 0.f, BidirectionalHeuristic(myStart, myGoal) }, IsLowerFScore);
+	myCameFrom.Add(myStart, myStart);
+	myGScore.Add(myStart, 0.f);
+
+	myBackwardOpen.HeapPush({ myGoal, 0.f, BidirectionalHeuristic(myGoal, myStart) }, IsLowerFScore);
+	myBackwardCameFrom.Add(myGoal, myGoal);
+	myBackwardGScore.Add(myGoal, 0.f);
+
+	// Cheapest start to goal path found so far, through the link where the frontiers met
+	myBestCost = myStart == myGoal ? 0.f : FLT_MAX;
+	myMeetingLink = myStart;
+}
+
+int SVONPathFinder::SearchPathBidirectional(FNavPathSharedPtr* oPath)
+{
+	myStatus = ESVONPathStatus::Failed;
+
+	while (myForwardOpen.Num() > 0 && myBackwardOpen.Num() > 0)
+	{
+		// Each frontier's lowest f is a lower bound on any path we haven't found yet
+		if (myBestCost <= myForwardOpen.HeapTop().myFScore || myBestCost <= myBackwardOpen.HeapTop().myFScore)
+			break;
+
+		// Out of budget, give back the best we've got from the start side
+		if (IsOutOfBudget())
+		{
+			myStatus = ESVONPathStatus::Partial;
+			BuildPath(myCameFrom, myBestLink, oPath);
+			UE_LOG(UESVON, Verbose, TEXT("Bidirectional pathfinding hit its search limit, iterations : %i"), myNumIterations);
+			return 0;
+		}
+
+		// Expand the smaller frontier, so neither side floods a big open region on its own
+		const bool forward = myForwardOpen.Num() <= myBackwardOpen.Num();
+
+		TArray<SVONSearchEntry>& openSet = forward ? myForwardOpen : myBackwardOpen;
+		TSet<SVONLink>& closedSet = forward ? myClosedSet : myBackwardClosedSet;
+		TMap<SVONLink, SVONLink>& cameFrom = forward ? myCameFrom : myBackwardCameFrom;
+		TMap<SVONLink, float>& gScores = forward ? myGScore : myBackwardGScore;
+		const TMap<SVONLink, float>& otherGScores = forward ? myBackwardGScore : myGScore;
+		const SVONLink& target = forward ? myGoal : myStart;
+
+		SVONSearchEntry current;
+		openSet.HeapPop(current, IsLowerFScore);
+
+		// Stale entry, already expanded through a cheaper route
+		if (closedSet.Contains(current.myLink))
+			continue;
+
+		closedSet.Add(current.myLink);
+		myNumIterations++;
+
+		if (forward && current.myFScore - current.myGScore < myBestHeuristic)
 		{
-			ProcessLink(neighbour);
+			myBestHeuristic = current.myFScore - current.myGScore;
+			myBestLink = current.myLink;
 		}
 
-		numIterations++;
+		// The backward side walks links in reverse, so it needs neighbours that are symmetric. Free neighbours are, as every
+		// neighbour with children is resolved down to the free space on the shared face
+		myNeighbours.Reset();
+		myVolume.GetFreeNeighbours(current.myLink, myNeighbours);
+
+		for (const SVONLink& neighbour : myNeighbours)
+		{
+			if (!neighbour.IsValid() || closedSet.Contains(neighbour))
+				continue;
+
+			if (myUseCorridor && !IsInCorridor(neighbour))
+				continue;
+
+			// The backward side's step is really from the neighbour to us
+			const float gScore = current.myGScore + (forward ? TraversalCost(current.myLink, neighbour) : TraversalCost(neighbour, current.myLink));
+			const float* existing = gScores.Find(neighbour);
+			if (existing && *existing <= gScore)
+				continue;
+
+			gScores.Add(neighbour, gScore);
+			cameFrom.Add(neighbour, current.myLink);
+			openSet.HeapPush({ neighbour, gScore, gScore + BidirectionalHeuristic(neighbour, target) }, IsLowerFScore);
+
+			if (myDebugOpenNodes)
+			{
+				FVector pos;
+				myVolume.GetLinkPosition(neighbour, pos);
+				myDebugPoints.Add(pos);
+			}
+
+			// The other side has been here too, so there's a path through this link
+			const float* otherGScore = otherGScores.Find(neighbour);
+			if (otherGScore && gScore + *otherGScore < myBestCost)
+			{
+				myBestCost = gScore + *otherGScore;
+				myMeetingLink = neighbour;
+			}
+		}
 	}
 
-	UE_LOG(UESVON, Display, TEXT("Pathfinding failed, iterations : %i"), numIterations);
-	return 0;
+	if (myBestCost == FLT_MAX)
+	{
+		UE_LOG(UESVON, Verbose, TEXT("Bidirectional pathfinding failed, iterations : %i"), myNumIterations);
+		return 0;
+	}
+
+	// Start side up to the meeting link, then the goal side back out from it
+	TArray<SVONLink> links;
+	SVONLink link = myMeetingLink;
+	links.Add(link);
+	while (!(myCameFrom[link] == link))
+	{
+		link = myCameFrom[link];
+		links.Add(link);
+	}
+	Algo::Reverse(links);
+
+	link = myMeetingLink;
+	while (!(myBackwardCameFrom[link] == link))
+	{
+		link = myBackwardCameFrom[link];
+		links.Add(link);
+	}
+
+	myStatus = ESVONPathStatus::Complete;
+	BuildPathFromLinks(links, oPath);
+	UE_LOG(UESVON, Verbose, TEXT("Bidirectional pathfinding complete, iterations : %i"), myNumIterations);
+	return 1;
+}
+
+void SVONPathFinder::FindPaths(const ASVONVolume& aVolume, TArrayView<const SVONPathRequest> aRequests, TArrayView<SVONPathResult> oResults, int32 aMaxWorkers, const SVONPathFinderSettings& aSettings)
+{
+	check(oResults.Num() >= aRequests.Num());
+
+	const int32 numRequests = aRequests.Num();
+	if (numRequests == 0)
+	{
+		return;
+	}
+
+	int32 numWorkers = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	if (aMaxWorkers > 0)
+	{
+		numWorkers = FMath::Min(numWorkers, aMaxWorkers);
+	}
+	numWorkers = FMath::Clamp(numWorkers, 1, numRequests);
+
+	// Workers pull the next unclaimed request from a shared counter, so a worker stuck on a long query
+	// doesn't hold up the rest of the batch
+	volatile int32 nextRequest = 0;
+
+	// Keeps the octree from being regenerated under the workers
+	aVolume.BeginPathQuery();
+
+	ParallelFor(numWorkers, [&](int32 aWorkerIndex)
+	{
+		TArray<FVector> debugPoints;
+		SVONPathFinder pathFinder(aVolume, false, nullptr, debugPoints, aSettings);
+
+		while (true)
+		{
+			const int32 index = FPlatformAtomics::InterlockedIncrement(&nextRequest) - 1;
+			if (index >= numRequests)
+			{
+				break;
+			}
+
+			const SVONPathRequest& request = aRequests[index];
+			SVONPathResult& result = oResults[index];
+
+			result.myResult = pathFinder.FindPath(request.myStart, request.myTarget, nullptr);
+			result.myStatus = pathFinder.GetStatus();
+			result.myNumIterations = pathFinder.GetNumIterations();
+			result.myPath = pathFinder.GetPath();
+		}
+	}, numWorkers == 1);
+
+	aVolume.EndPathQuery();
 }
 
 const FNavigationPath& SVONPathFinder::GetNavPath()
@@ -78,24 +438,87 @@ const FNavigationPath& SVONPathFinder::GetNavPath()
 
 float SVONPathFinder::HeuristicScore( const SVONLink& aStart, const SVONLink& aTarget)
 {
-	/* Just using manhattan distance for now */
-
 	FVector startPos, endPos;
 	myVolume.GetLinkPosition(aStart, startPos);
 	myVolume.GetLinkPosition(aTarget, endPos);
-	return FMath::Abs(endPos.X - startPos.X) + FMath::Abs(endPos.Y - startPos.Y) + FMath::Abs(endPos.Z - startPos.Z);
+
+	// ALT: by the triangle inequality, |d(L, goal) - d(L, n)| never overestimates d(n, goal), for any landmark L.
+	// The tables hold euclidean path lengths, so they only mean anything with euclidean costs
+	if (myGoalLandmarkDistances.Num() > 0 && mySettings.myPathCostType == ESVONPathCostType::Euclidean)
+	{
+		float score = (endPos - startPos).Size();
+
+		const int32 navIndex = myVolume.GetNavIndex(aStart);
+		for (int32 i = 0; navIndex != INDEX_NONE && i < myGoalLandmarkDistances.Num(); i++)
+		{
+			const float linkDistance = myVolume.GetLandmarkDistance(i, navIndex);
+			if (linkDistance != FLT_MAX && myGoalLandmarkDistances[i] != FLT_MAX)
+			{
+				score = FMath::Max(score, FMath::Abs(myGoalLandmarkDistances[i] - linkDistance));
+			}
+		}
+		return score * mySettings.myHeuristicWeight;
+	}
+
+	/* Just using manhattan distance for now */
+	return (FMath::Abs(endPos.X - startPos.X) + FMath::Abs(endPos.Y - startPos.Y) + FMath::Abs(endPos.Z - startPos.Z)) * mySettings.myHeuristicWeight;
+}
+
+float SVONPathFinder::BidirectionalHeuristic(const SVONLink& aStart, const SVONLink& aTarget)
+{
+	return DistanceBetween(aStart, aTarget) * myBidirectionalHeuristicScale;
 }
 
 float SVONPathFinder::DistanceBetween( const SVONLink& aStart, const SVONLink& aTarget)
 {
 	FVector startPos(0.f), endPos(0.f);
-	const SVONNode& startNode = myVolume.GetNode(aStart);
-	const SVONNode& endNode = myVolume.GetNode(aTarget);
 	myVolume.GetLinkPosition(aStart, startPos);
 	myVolume.GetLinkPosition(aTarget, endPos);
 	return (startPos - endPos).Size();
 }
 
+float SVONPathFinder::TraversalCost(const SVONLink& aStart, const SVONLink& aTarget)
+{
+	switch (mySettings.myPathCostType)
+	{
+	// One layer 0 node's width per step, whatever size the step is. Jumps and line of sight shortcuts cover several steps at once
+	case ESVONPathCostType::UnitCost:
+	{
+		const float stepSize = FMath::Max(GetLinkSize(aStart), GetLinkSize(aTarget));
+		return myVolume.GetVoxelSize(0) * FMath::Max(FMath::RoundToFloat(DistanceBetween(aStart, aTarget) / stepSize), 1.f);
+	}
+	// Entering a node twice the size costs half as much per unit distance
+	case ESVONPathCostType::SizeScaled:
+		return DistanceBetween(aStart, aTarget) * myVolume.GetVoxelSize(0) / GetLinkSize(aTarget);
+	default:
+		return DistanceBetween(aStart, aTarget);
+	}
+}
+
+bool SVONPathFinder::IsOutOfBudget() const
+{
+	return (mySettings.myMaxIterations > 0 && myNumIterations >= mySettings.myMaxIterations)
+		|| (mySettings.myMaxMilliseconds > 0.f && (FPlatformTime::Seconds() - mySearchStartTime) * 1000.0 >= mySettings.myMaxMilliseconds);
+}
+
+float SVONPathFinder::GetLinkSize(const SVONLink& aLink) const
+{
+	const layerindex_t layer = aLink.GetLayerIndex();
+	if (layer == 0 && myVolume.GetNodeFirstChild(0, aLink.GetNodeIndex()).IsValid())
+	{
+		return myVolume.GetVoxelSize(0) * 0.25f;
+	}
+	return myVolume.GetVoxelSize(layer);
+}
+
+bool SVONPathFinder::HasLineOfSight(const SVONLink& aStart, const SVONLink& aTarget) const
+{
+	FVector startPos, endPos;
+	myVolume.GetLinkPosition(aStart, startPos);
+	myVolume.GetLinkPosition(aTarget, endPos);
+	return myVolume.HasLineOfSight(startPos, endPos);
+}
+
 void SVONPathFinder::ProcessLink(const SVONLink& aNeighbour)
 {
 	if (aNeighbour.IsValid())
@@ -103,6 +526,9 @@ void SVONPathFinder::ProcessLink(const SVONLink& aNeighbour)
 		if (myClosedSet.Contains(aNeighbour))
 			return;
 
+		if (myUseCorridor && !IsInCorridor(aNeighbour))
+			return;
+
 		if (!myOpenSet.Contains(aNeighbour))
 		{
 			myOpenSet.Add(aNeighbour);
@@ -116,43 +542,621 @@ void SVONPathFinder::ProcessLink(const SVONLink& aNeighbour)
 
 		}
 
+		SVONLink parent = myCurrent;
+
 		float t_gScore = FLT_MAX;
 		if (myGScore.Contains(myCurrent))
-			t_gScore = myGScore[myCurrent] + DistanceBetween(myCurrent, aNeighbour);
+			t_gScore = myGScore[myCurrent] + TraversalCost(myCurrent, aNeighbour);
 		else
 			myGScore.Add(myCurrent, FLT_MAX);
 
+		// Theta*: if our parent can see the neighbour, go straight there from the parent instead
+		if (mySettings.myUseThetaStar && myCameFrom.Contains(myCurrent))
+		{
+			const SVONLink& grandParent = myCameFrom[myCurrent];
+			if (!(grandParent == myCurrent) && HasLineOfSight(grandParent, aNeighbour))
+			{
+				parent = grandParent;
+				t_gScore = myGScore[grandParent] + TraversalCost(grandParent, aNeighbour);
+			}
+		}
+
 		if (t_gScore >= (myGScore.Contains(aNeighbour) ? myGScore[aNeighbour] : FLT_MAX))
 			return;
 
-		myCameFrom.Add(aNeighbour, myCurrent);
+		myCameFrom.Add(aNeighbour, parent);
+		if (myUseJumps)
+		{
+			myJumpDirections.Add(aNeighbour, myJumpDirection);
+		}
 		myGScore.Add(aNeighbour, t_gScore);
 		myFScore.Add(aNeighbour, myGScore[aNeighbour] + HeuristicScore(aNeighbour, myGoal));
 	}
 }
 
+struct SVONCorridorEntry
+{
+	mortoncode_t myCode;
+	float myGScore;
+	float myFScore;
+};
+
+bool SVONPathFinder::BuildCorridor(const SVONLink& aStart, const SVONLink& aGoal)
+{
+	myCorridor.Reset();
+
+	if (myVolume.GetMyNumLayers() < 2)
+	{
+		return false;
+	}
+
+	myCorridorLayer = FMath::Clamp<int32>(mySettings.myCorridorLayer, 1, myVolume.GetMyNumLayers() - 1);
+
+	const int32 cellsPerSide = myVolume.GetNodesPerSide(myCorridorLayer);
+	const float cellSize = myVolume.GetVoxelSize(myCorridorLayer);
+
+	FIntVector startCell, goalCell;
+	if (!GetCorridorCell(aStart, startCell) || !GetCorridorCell(aGoal, goalCell))
+	{
+		return false;
+	}
+
+	const mortoncode_t startCode = morton3D_64_encode(startCell.X, startCell.Y, startCell.Z);
+	const mortoncode_t goalCode = morton3D_64_encode(goalCell.X, goalCell.Y, goalCell.Z);
+
+	auto heuristic = [&](const FIntVector& aCell)
+	{
+		return FVector(aCell - goalCell).Size() * cellSize;
+	};
+
+	auto heapPredicate = [](const SVONCorridorEntry& A, const SVONCorridorEntry& B)
+	{
+		return A.myFScore < B.myFScore;
+	};
+
+	TArray<SVONCorridorEntry> open;
+	TMap<mortoncode_t, float> gScores;
+	TMap<mortoncode_t, mortoncode_t> cameFrom;
+
+	open.HeapPush({ startCode, 0.f, heuristic(startCell) }, heapPredicate);
+	gScores.Add(startCode, 0.f);
+	cameFrom.Add(startCode, startCode);
+
+	bool foundGoal = false;
+
+	while (open.Num() > 0)
+	{
+		SVONCorridorEntry current;
+		open.HeapPop(current, heapPredicate);
+
+		// Stale entry, we've since found a cheaper way here
+		if (current.myGScore > gScores[current.myCode])
+			continue;
+
+		if (current.myCode == goalCode)
+		{
+			foundGoal = true;
+			break;
+		}
+
+		uint_fast32_t x, y, z;
+		morton3D_64_decode(current.myCode, x, y, z);
+
+		for (int d = 0; d < 6; d++)
+		{
+			const FIntVector cell = FIntVector(x, y, z) + SVONStatics::dirs[d];
+			if (cell.X < 0 || cell.Y < 0 || cell.Z < 0 || cell.X >= cellsPerSide || cell.Y >= cellsPerSide || cell.Z >= cellsPerSide)
+				continue;
+
+			const mortoncode_t code = morton3D_64_encode(cell.X, cell.Y, cell.Z);
+
+			// A cell missing from the layer is inside a free ancestor, one with children has some blocking in it
+			float cost = cellSize;
+			nodeindex_t nodeIndex;
+			if (myVolume.GetIndexForCode(myCorridorLayer, code, nodeIndex) && myVolume.GetNodeFirstChild(myCorridorLayer, nodeIndex).IsValid())
+			{
+				cost *= mySettings.myPartiallyBlockedPenalty;
+			}
+
+			const float gScore = current.myGScore + cost;
+			const float* existing = gScores.Find(code);
+			if (existing && *existing <= gScore)
+				continue;
+
+			gScores.Add(code, gScore);
+			cameFrom.Add(code, current.myCode);
+			open.HeapPush({ code, gScore, gScore + heuristic(cell) }, heapPredicate);
+		}
+	}
+
+	if (!foundGoal)
+	{
+		return false;
+	}
+
+	// Walk back along the coarse path, widening it by the padding as we go
+	myCorridor.AddDefaulted(myVolume.GetMyNumLayers() - myCorridorLayer);
+	const int32 padding = FMath::Max(mySettings.myCorridorPadding, 0);
+
+	mortoncode_t code = goalCode;
+	while (true)
+	{
+		uint_fast32_t x, y, z;
+		morton3D_64_decode(code, x, y, z);
+
+		for (int32 pX = -padding; pX <= padding; pX++)
+		for (int32 pY = -padding; pY <= padding; pY++)
+		for (int32 pZ = -padding; pZ <= padding; pZ++)
+		{
+			const FIntVector cell = FIntVector(x + pX, y + pY, z + pZ);
+			if (cell.X < 0 || cell.Y < 0 || cell.Z < 0 || cell.X >= cellsPerSide || cell.Y >= cellsPerSide || cell.Z >= cellsPerSide)
+				continue;
+
+			const mortoncode_t cellCode = morton3D_64_encode(cell.X, cell.Y, cell.Z);
+			for (int32 i = 0; i < myCorridor.Num(); i++)
+			{
+				myCorridor[i].Add(cellCode >> (3 * i));
+			}
+		}
+
+		const mortoncode_t previous = cameFrom[code];
+		if (previous == code)
+			break;
+		code = previous;
+	}
+
+	return true;
+}
+
+bool SVONPathFinder::GetCorridorCell(const SVONLink& aLink, FIntVector& oCell) const
+{
+	FVector position;
+	myVolume.GetLinkPosition(aLink, position);
+
+	const FVector localPos = position - (myVolume.GetOrigin() - myVolume.GetExtent());
+	const float cellSize = myVolume.GetVoxelSize(myCorridorLayer);
+	const int32 maxCell = myVolume.GetNodesPerSide(myCorridorLayer) - 1;
+
+	oCell.X = FMath::Clamp(FMath::FloorToInt(localPos.X / cellSize), 0, maxCell);
+	oCell.Y = FMath::Clamp(FMath::FloorToInt(localPos.Y / cellSize), 0, maxCell);
+	oCell.Z = FMath::Clamp(FMath::FloorToInt(localPos.Z / cellSize), 0, maxCell);
+	return true;
+}
+
+bool SVONPathFinder::IsInCorridor(const SVONLink& aLink) const
+{
+	const layerindex_t layer = aLink.GetLayerIndex();
+	const mortoncode_t code = myVolume.GetNodeCode(layer, aLink.GetNodeIndex());
+
+	// Finer than the corridor, test the cell we're in
+	if (layer <= myCorridorLayer)
+	{
+		return myCorridor[0].Contains(code >> (3 * (myCorridorLayer - layer)));
+	}
+
+	// Coarser than the corridor, test if any corridor cell is inside us
+	const int32 corridorIndex = layer - myCorridorLayer;
+	return corridorIndex < myCorridor.Num() && myCorridor[corridorIndex].Contains(code);
+}
+
+// The morton bits for a position along one axis of a leaf
+static inline uint_fast64_t GetLeafAxisBits(int32 aAxis, int32 aPosition)
+{
+	return ((uint_fast64_t)(aPosition & 1) << aAxis) | ((uint_fast64_t)((aPosition >> 1) & 1) << (aAxis + 3));
+}
+
+// Position of a subnode along an axis, counted in the direction of travel
+static inline int32 GetTravelPosition(uint_fast64_t aSubnode, int32 aAxis, bool aReversed)
+{
+	const int32 position = (int32)(((aSubnode >> aAxis) & 1) | (((aSubnode >> (aAxis + 3)) & 1) << 1));
+	return aReversed ? 3 - position : position;
+}
+
+// The 4 bit rows, reversed
+static const uint8 SVONReversedRows[16] = { 0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF };
+
+// Blocked mask of the four subnodes along an axis through aBase, bit 0 is the first one we'd travel through
+static inline uint32 GetLeafRow(uint_fast64_t aGrid, int32 aAxis, uint_fast64_t aBase, bool aReversed)
+{
+	// Along an axis, the subnodes are at aBase plus 0, 1, 8 and 9 shifted by the axis
+	const uint_fast64_t grid = aGrid >> aBase;
+	const uint32 row = (uint32)((grid & 1) | (((grid >> (1 << aAxis)) & 1) << 1) | (((grid >> (8 << aAxis)) & 1) << 2) | (((grid >> (9 << aAxis)) & 1) << 3));
+	return aReversed ? SVONReversedRows[row] : row;
+}
+
+bool SVONPathFinder::IsLeafSubnode(const SVONLink& aLink) const
+{
+	return aLink.GetLayerIndex() == 0 && myVolume.GetNodeFirstChild(0, aLink.GetNodeIndex()).IsValid();
+}
+
+uint32 SVONPathFinder::GetJumpSideRow(nodeindex_t aNodeIndex, uint_fast64_t aGrid, uint_fast64_t aBase, int32 aAxis, int32 aSide, bool aReversed, SVONLink& oOpenLink) const
+{
+	oOpenLink = SVONLink::GetInvalidLink();
+
+	const int32 sideAxis = aSide / 2;
+
+	uint_fast32_t coords[3];
+	morton3D_64_decode(aBase, coords[0], coords[1], coords[2]);
+	const int32 sideCoord = (int32)coords[sideAxis] + SVONStatics::dirs[aSide][sideAxis];
+
+	if (sideCoord >= 0 && sideCoord < 4)
+	{
+		coords[sideAxis] = sideCoord;
+		return GetLeafRow(aGrid, aAxis, morton3D_64_encode(coords[0], coords[1], coords[2]), aReversed);
+	}
+
+	// The row beside us is in the neighbouring node, which is either off the edge, open space, or another leaf
+	const SVONLink& neighbourLink = myVolume.GetNodeNeighbours(0, aNodeIndex)[aSide];
+	if (!neighbourLink.IsValid())
+		return 0xF;
+
+	const SVONLink& neighbourChild = myVolume.GetNodeFirstChild(neighbourLink.GetLayerIndex(), neighbourLink.GetNodeIndex());
+	if (!neighbourChild.IsValid())
+	{
+		oOpenLink = neighbourLink;
+		return 0;
+	}
+
+	coords[sideAxis] = sideCoord < 0 ? 3 : 0;
+	const uint_fast64_t neighbourGrid = myVolume.GetLeafNode(neighbourChild.GetNodeIndex()).myVoxelGrid;
+	return GetLeafRow(neighbourGrid, aAxis, morton3D_64_encode(coords[0], coords[1], coords[2]), aReversed);
+}
+
+SVONLink SVONPathFinder::Jump(const SVONLink& aLink, int32 aDirection) const
+{
+	const int32 axis = aDirection / 2;
+	const bool reversed = (aDirection & 1) != 0;
+	const uint_fast64_t axisBits = GetLeafAxisBits(axis, 3);
+	const uint_fast64_t base = aLink.GetSubnodeIndex() & ~axisBits;
+
+	nodeindex_t nodeIndex = aLink.GetNodeIndex();
+	int32 position = GetTravelPosition(aLink.GetSubnodeIndex(), axis, reversed);
+
+	// For each side, whether the cell beside the last one we passed is a free subnode, and the open space there if it's outside the leaf
+	uint32 carry[4] = { 0, 0, 0, 0 };
+	SVONLink carryOpen[4];
+	bool isFirstLeaf = true;
+
+	// One leaf's row at a time, until the row runs into something
+	while (true)
+	{
+		const uint_fast64_t grid = myVolume.GetLeafNode(myVolume.GetNodeFirstChild(0, nodeIndex).GetNodeIndex()).myVoxelGrid;
+
+		// The cells ahead of us in this leaf, up to the first blocked one
+		const uint32 ahead = (0xFu << (position + 1)) & 0xF;
+		const uint32 blocked = GetLeafRow(grid, axis, base, reversed) & ahead;
+		const uint32 range = blocked ? ahead & ((1u << FMath::CountTrailingZeros(blocked)) - 1) : ahead;
+
+		uint32 stops = 0;
+		int32 side = 0;
+		for (int32 d = 0; d < 6; d++)
+		{
+			if (d / 2 == axis)
+				continue;
+
+			SVONLink openLink;
+			const uint32 sideRow = GetJumpSideRow(nodeIndex, grid, base, axis, d, reversed, openLink);
+			const uint32 freeRow = openLink.IsValid() ? 0 : ~sideRow & 0xF;
+
+			// A free side subnode, when the side of the cell before was blocked or open space, is a forced neighbour.
+			// The open space beside a row is the same node all along it, so it can only change where we enter a leaf
+			if (isFirstLeaf)
+			{
+				stops |= freeRow & ~(freeRow << 1);
+			}
+			else
+			{
+				stops |= freeRow & ~((freeRow << 1) | carry[side]);
+				if (openLink.IsValid() && !(openLink == carryOpen[side]))
+				{
+					stops |= 1;
+				}
+			}
+
+			carry[side] = (freeRow >> 3) & 1;
+			carryOpen[side] = openLink;
+			side++;
+		}
+
+		// The start cell has nothing to stop for
+		stops &= range;
+
+		if (myGoal.GetLayerIndex() == 0 && myGoal.GetNodeIndex() == nodeIndex && (myGoal.GetSubnodeIndex() & ~axisBits) == base)
+		{
+			stops |= (1u << GetTravelPosition(myGoal.GetSubnodeIndex(), axis, reversed)) & range;
+		}
+
+		// Stop at the first forced cell, or the first one where turning onto a lower axis finds a jump point
+		for (uint32 cells = range; cells; cells &= cells - 1)
+		{
+			const int32 cellPosition = FMath::CountTrailingZeros(cells);
+			const SVONLink cell(0, nodeIndex, base | GetLeafAxisBits(axis, reversed ? 3 - cellPosition : cellPosition));
+
+			if (stops & (1u << cellPosition))
+				return cell;
+
+			for (int32 lower = 0; lower < axis * 2; lower++)
+			{
+				if (Jump(cell, lower).IsValid())
+					return cell;
+			}
+		}
+
+		if (blocked)
+			return SVONLink::GetInvalidLink();
+
+		// Off the end of this leaf's row, into the next node along
+		const SVONLink& neighbourLink = myVolume.GetNodeNeighbours(0, nodeIndex)[aDirection];
+		if (!neighbourLink.IsValid())
+			return SVONLink::GetInvalidLink();
+
+		// Out into open space, which is as far as a jump goes
+		if (!myVolume.GetNodeFirstChild(neighbourLink.GetLayerIndex(), neighbourLink.GetNodeIndex()).IsValid())
+			return neighbourLink;
+
+		nodeIndex = neighbourLink.GetNodeIndex();
+		position = -1;
+		isFirstLeaf = false;
+	}
+}
+
+void SVONPathFinder::ProcessJumpSuccessors()
+{
+	const int8* arrival = myJumpDirections.Find(myCurrent);
+	const int32 direction = arrival ? *arrival : -1;
+
+	// The start, or somewhere we entered from a bigger node, has nothing to prune against
+	uint32 directions = 0x3F;
+
+	if (direction >= 0)
+	{
+		const int32 axis = direction / 2;
+
+		// Carry straight on, or turn onto a lower axis
+		directions = (1u << direction) | ((1u << (axis * 2)) - 1);
+
+		// Plus any free side cell whose counterpart beside the cell behind us isn't a free subnode, and any open space beside us,
+		// which isn't on the subnode grid the pruning rules are about
+		SVONLink behind;
+		const bool hasBehind = myVolume.GetLeafNeighbour(myCurrent, direction ^ 1, behind) && IsLeafSubnode(behind);
+
+		for (int32 d = 0; d < 6; d++)
+		{
+			SVONLink sideLink, behindSideLink;
+			if (d / 2 == axis || !myVolume.GetLeafNeighbour(myCurrent, d, sideLink))
+				continue;
+
+			if (!IsLeafSubnode(sideLink) || !hasBehind || !myVolume.GetLeafNeighbour(behind, d, behindSideLink) || !IsLeafSubnode(behindSideLink))
+			{
+				directions |= 1u << d;
+			}
+		}
+	}
+
+	for (int32 d = 0; d < 6; d++)
+	{
+		SVONLink neighbour;
+		if (!(directions & (1u << d)) || !myVolume.GetLeafNeighbour(myCurrent, d, neighbour))
+			continue;
+
+		myJumpDirection = d;
+		ProcessLink(IsLeafSubnode(neighbour) ? Jump(myCurrent, d) : neighbour);
+	}
+
+	myJumpDirection = -1;
+}
+
+void SVONPathFinder::ExpandJumps(TArray<SVONLink>& aLinks) const
+{
+	TArray<SVONLink> expanded;
+	expanded.Reserve(aLinks.Num());
+
+	for (int32 i = 0; i < aLinks.Num(); i++)
+	{
+		// Fill in the cells a jump skipped, so the path's links still cover everything it passes through
+		const int8* direction = i > 0 ? myJumpDirections.Find(aLinks[i]) : nullptr;
+		if (direction && *direction >= 0 && IsLeafSubnode(aLinks[i - 1]))
+		{
+			SVONLink step = aLinks[i - 1];
+			SVONLink next;
+			while (myVolume.GetLeafNeighbour(step, *direction, next) && !(next == aLinks[i]) && IsLeafSubnode(next))
+			{
+				expanded.Add(next);
+				step = next;
+			}
+		}
+
+		expanded.Add(aLinks[i]);
+	}
+
+	aLinks = MoveTemp(expanded);
+}
+
 void SVONPathFinder::BuildPath(TMap<SVONLink, SVONLink>& aCameFrom, SVONLink aCurrent, FNavPathSharedPtr* oPath)
 {
-	
+	TArray<SVONLink> links;
+
+	links.Add(aCurrent);
+
+	while (aCameFrom.Contains(aCurrent) && !(aCurrent == aCameFrom[aCurrent]))
+	{
+		aCurrent = aCameFrom[aCurrent];
+		links.Add(aCurrent);
+	}
+
+	Algo::Reverse(links);
+
+	if (myUseJumps)
+	{
+		ExpandJumps(links);
+	}
+
+	BuildPathFromLinks(links, oPath);
+}
+
+void SVONPathFinder::BuildPathFromLinks(const TArray<SVONLink>& aLinks, FNavPathSharedPtr* oPath)
+{
 	FVector pos;
 
-	TArray<FVector> points;
+	myPath.ResetPath();
+
+	// Keep the traversed links, so the path can be cheaply revalidated against changed regions later
+	for (const SVONLink& link : aLinks)
+	{
+		myPath.AddLink(link, myVolume.GetNodeCode(link.GetLayerIndex(), link.GetNodeIndex()));
+	}
+
+	// Smooth with the goal link's position in, so the stages know where the path ends
+	myPathPoints.Reset();
+	for (const SVONLink& link : aLinks)
+	{
+		myVolume.GetLinkPosition(link, pos);
+		myPathPoints.Add(pos);
+	}
+
+	SmoothPath(myPathPoints);
+
+	// Points run from the start up to the one before the goal, callers add the exact target position.
+	// A partial path doesn't reach the goal, so it ends on the best link itself
+	const int32 numPoints = myStatus == ESVONPathStatus::Partial ? myPathPoints.Num() : myPathPoints.Num() - 1;
+	for (int i = 0; i < numPoints; i++)
+	{
+		myPath.AddPoint(myPathPoints[i]);
+	}
 
 	if (!oPath || !oPath->IsValid())
 		return;
 
-	while (aCameFrom.Contains(aCurrent) && !(aCurrent == aCameFrom[aCurrent]))
+	for (const FVector& point : myPath.GetPoints())
 	{
-		aCurrent = aCameFrom[aCurrent];
-		myVolume.GetLinkPosition(aCurrent, pos);
-		points.Add(pos);
-		
+		oPath->Get()->GetPathPoints().Add(point);
+	}
+}
+
+void SVONPathFinder::SmoothPath(TArray<FVector>& aPoints)
+{
+	mySmoothingStats = SVONPathSmoothingStats();
+	mySmoothingStats.myNumRawPoints = aPoints.Num();
+
+	double stageStart = FPlatformTime::Seconds();
+	if (mySettings.myStringPullPath)
+	{
+		StringPullPath(aPoints);
+		mySmoothingStats.myPullMilliseconds = (FPlatformTime::Seconds() - stageStart) * 1000.0;
 	}
+	mySmoothingStats.myNumPulledPoints = aPoints.Num();
 
-	for (int i = points.Num() - 1; i >= 0; i--)
+	stageStart = FPlatformTime::Seconds();
+	if (mySettings.myResamplePath)
 	{
-		oPath->Get()->GetPathPoints().Add(points[i]);
+		ResamplePath(aPoints);
+		mySmoothingStats.myResampleMilliseconds = (FPlatformTime::Seconds() - stageStart) * 1000.0;
 	}
-	
-	
+	mySmoothingStats.myNumResampledPoints = aPoints.Num();
+
+	stageStart = FPlatformTime::Seconds();
+	if (mySettings.myRemoveCollinearPoints)
+	{
+		RemoveCollinearPoints(aPoints);
+		mySmoothingStats.myCollinearMilliseconds = (FPlatformTime::Seconds() - stageStart) * 1000.0;
+	}
+	mySmoothingStats.myNumFinalPoints = aPoints.Num();
+}
+
+void SVONPathFinder::StringPullPath(TArray<FVector>& aPoints)
+{
+	if (aPoints.Num() < 3)
+		return;
+
+	mySmoothingScratch.Reset();
+	mySmoothingScratch.Add(aPoints[0]);
+
+	int32 anchor = 0;
+	while (anchor < aPoints.Num() - 1)
+	{
+		// Walk forward while the anchor can still see the next point, the last one it could see becomes the new anchor
+		int32 next = anchor + 1;
+		while (next + 1 < aPoints.Num() && myVolume.HasLineOfSight(aPoints[anchor], aPoints[next + 1]))
+		{
+			next++;
+		}
+
+		mySmoothingScratch.Add(aPoints[next]);
+		anchor = next;
+	}
+
+	Swap(aPoints, mySmoothingScratch);
+}
+
+void SVONPathFinder::ResamplePath(TArray<FVector>& aPoints)
+{
+	if (aPoints.Num() < 2 || mySettings.myResampleSpacing <= 0.f)
+		return;
+
+	mySmoothingScratch.Reset();
+	mySmoothingScratch.Add(aPoints[0]);
+
+	for (int32 i = 0; i < aPoints.Num() - 1; i++)
+	{
+		// Uniform Catmull-Rom between P1 and P2, with the ends duplicated
+		const FVector& p0 = aPoints[FMath::Max(i - 1, 0)];
+		const FVector& p1 = aPoints[i];
+		const FVector& p2 = aPoints[i + 1];
+		const FVector& p3 = aPoints[FMath::Min(i + 2, aPoints.Num() - 1)];
+
+		const int32 numSamples = FMath::Max(FMath::CeilToInt(FVector::Dist(p1, p2) / mySettings.myResampleSpacing), 1);
+		const int32 segmentStart = mySmoothingScratch.Num();
+
+		bool isClear = true;
+		for (int32 s = 1; s <= numSamples && isClear; s++)
+		{
+			const float t = (float)s / numSamples;
+			const float t2 = t * t;
+			const float t3 = t2 * t;
+
+			const FVector point = 0.5f * ((2.f * p1)
+				+ (p2 - p0) * t
+				+ (2.f * p0 - 5.f * p1 + 4.f * p2 - p3) * t2
+				+ (3.f * p1 - p0 - 3.f * p2 + p3) * t3);
+
+			isClear = myVolume.HasLineOfSight(mySmoothingScratch.Last(), point);
+			mySmoothingScratch.Add(point);
+		}
+
+		// The curve bulged into something, keep this segment straight
+		if (!isClear)
+		{
+			mySmoothingScratch.SetNum(segmentStart);
+			mySmoothingScratch.Add(p2);
+		}
+	}
+
+	Swap(aPoints, mySmoothingScratch);
+}
+
+void SVONPathFinder::RemoveCollinearPoints(TArray<FVector>& aPoints)
+{
+	// Sine of the largest turn we still count as straight
+	static const float collinearTolerance = 0.01f;
+
+	if (aPoints.Num() < 3)
+		return;
+
+	mySmoothingScratch.Reset();
+	mySmoothingScratch.Add(aPoints[0]);
+
+	for (int32 i = 1; i < aPoints.Num() - 1; i++)
+	{
+		const FVector in = (aPoints[i] - mySmoothingScratch.Last()).GetSafeNormal();
+		const FVector out = (aPoints[i + 1] - aPoints[i]).GetSafeNormal();
+
+		if (FVector::DotProduct(in, out) > 0.f && FVector::CrossProduct(in, out).Size() < collinearTolerance)
+			continue;
+
+		mySmoothingScratch.Add(aPoints[i]);
+	}
+
+	mySmoothingScratch.Add(aPoints.Last());
+
+	Swap(aPoints, mySmoothingScratch);
 }
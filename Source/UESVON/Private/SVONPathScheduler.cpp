@@ -0,0 +1,277 @@
+#include "SVONPathScheduler.h"
+#include "SVONVolume.h"
+#include "SVONPathFinder.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("SVONPathScheduler Tick"), STAT_SVONPathSchedulerTick, STATGROUP_AI);
+
+static const int32 SVONLatencySamples = 256;
+
+TMap<TWeakObjectPtr<UWorld>, TSharedPtr<SVONPathScheduler>> SVONPathScheduler::ourSchedulers;
+
+SVONPathScheduler::SVONPathScheduler(UWorld* aWorld)
+	: myWorld(aWorld)
+{
+	for (int32& head : myQueueHeads)
+	{
+		head = 0;
+	}
+}
+
+SVONPathScheduler& SVONPathScheduler::Get(UWorld* aWorld)
+{
+	static bool registeredCleanup = false;
+	if (!registeredCleanup)
+	{
+		FWorldDelegates::OnWorldCleanup.AddStatic(&SVONPathScheduler::OnWorldCleanup);
+		registeredCleanup = true;
+	}
+
+	TSharedPtr<SVONPathScheduler>& scheduler = ourSchedulers.FindOrAdd(aWorld);
+	if (!scheduler.IsValid())
+	{
+		scheduler = MakeShareable(new SVONPathScheduler(aWorld));
+	}
+	return *scheduler;
+}
+
+void SVONPathScheduler::OnWorldCleanup(UWorld* aWorld, bool aSessionEnded, bool aCleanupResources)
+{
+	ourSchedulers.Remove(aWorld);
+}
+
+SVONPathScheduler::SVONScheduledSearch::SVONScheduledSearch(ASVONVolume& aVolume, const SVONPathFinderSettings& aSettings, TArray<FVector>& aDebugPoints)
+	: myVolume(aVolume),
+	myPathFinder(aVolume, false, aVolume.GetWorld(), aDebugPoints, aSettings)
+{
+	myVolume.BeginPathQuery();
+}
+
+SVONPathScheduler::SVONScheduledSearch::~SVONScheduledSearch()
+{
+	myVolume.EndPathQuery();
+}
+
+bool SVONPathScheduler::RequestPath(ASVONVolume& aVolume, const SVONLink& aStart, const SVONLink& aTarget, ESVONPathPriority aPriority, const SVONPathFinderSettings& aSettings, const FSVONScheduledPathComplete& aOnComplete)
+{
+	if (!aStart.IsValid() || !aTarget.IsValid() || aPriority >= ESVONPathPriority::Num)
+	{
+		return false;
+	}
+
+	SVONRequestKey key;
+	key.myVolume = &aVolume;
+	key.myStart = aStart;
+	key.myTarget = aTarget;
+	key.mySettings = aSettings;
+
+	// Someone's already asked for this, just piggyback on their request
+	if (uint32* existingId = myRequestIds.Find(key))
+	{
+		SVONScheduledRequest& existing = myRequests[*existingId];
+		existing.myCallbacks.Add(aOnComplete);
+
+		// Promote it if we're more urgent. The stale entry in the lower queue will be skipped
+		if (aPriority > existing.myPriority)
+		{
+			existing.myPriority = aPriority;
+			myQueues[(uint8)aPriority].Add(*existingId);
+		}
+		return true;
+	}
+
+	const uint32 id = myNextRequestId++;
+
+	SVONScheduledRequest& request = myRequests.Add(id);
+	request.myVolume = &aVolume;
+	request.myKey = key;
+	request.myPriority = aPriority;
+	request.myQueuedTime = FPlatformTime::Seconds();
+	request.myCallbacks.Add(aOnComplete);
+
+	myRequestIds.Add(key, id);
+	myQueues[(uint8)aPriority].Add(id);
+
+	return true;
+}
+
+void SVONPathScheduler::SetFrameBudget(float aMaxMilliseconds, int32 aMaxIterations)
+{
+	myMaxMilliseconds = aMaxMilliseconds;
+	myMaxIterations = aMaxIterations;
+}
+
+float SVONPathScheduler::GetLatencyPercentile(float aPercentile) const
+{
+	if (myLatencies.Num() == 0)
+	{
+		return 0.f;
+	}
+
+	TArray<float> sorted = myLatencies;
+	sorted.Sort();
+
+	const int32 index = FMath::Clamp(FMath::CeilToInt(aPercentile * 0.01f * sorted.Num()) - 1, 0, sorted.Num() - 1);
+	return sorted[index];
+}
+
+TStatId SVONPathScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(SVONPathScheduler, STATGROUP_Tickables);
+}
+
+// The tighter of two limits, where 0 means no limit
+template<typename T>
+static T GetTighterLimit(T aLimit, T aOther)
+{
+	return aLimit <= 0 ? aOther : (aOther <= 0 ? aLimit : FMath::Min(aLimit, aOther));
+}
+
+void SVONPathScheduler::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SVONPathSchedulerTick);
+
+	const double startTime = FPlatformTime::Seconds();
+	int32 iterations = 0;
+	uint32 requestId = 0;
+
+	while (PopNextRequest(requestId))
+	{
+		// Each search gets whatever's left of the frame. Never 0 though, which the pathfinder takes as no limit
+		const float elapsedMs = (FPlatformTime::Seconds() - startTime) * 1000.0;
+		const int32 maxIterations = myMaxIterations > 0 ? FMath::Max(myMaxIterations - iterations, 1) : 0;
+		const float maxMilliseconds = myMaxMilliseconds > 0.f ? FMath::Max(myMaxMilliseconds - elapsedMs, KINDA_SMALL_NUMBER) : 0.f;
+
+		SVONScheduledRequest& request = myRequests[requestId];
+		if (!ProcessRequest(request, maxIterations, maxMilliseconds, iterations))
+		{
+			// The frame's budget is spent. Put it back at the front of its queue, to carry on from here next frame
+			myQueueHeads[(uint8)request.myPriority]--;
+			break;
+		}
+
+		SVONScheduledRequest finished;
+		myRequests.RemoveAndCopyValue(requestId, finished);
+		myRequestIds.Remove(finished.myKey);
+
+		CompleteRequest(finished);
+
+		if ((myMaxMilliseconds > 0.f && (FPlatformTime::Seconds() - startTime) * 1000.0 >= myMaxMilliseconds)
+			|| (myMaxIterations > 0 && iterations >= myMaxIterations))
+		{
+			break;
+		}
+	}
+}
+
+bool SVONPathScheduler::PopNextRequest(uint32& oRequestId)
+{
+	// Highest priority first, oldest first within a priority
+	for (int32 priority = (int32)ESVONPathPriority::Num - 1; priority >= 0; priority--)
+	{
+		TArray<uint32>& queue = myQueues[priority];
+		int32& head = myQueueHeads[priority];
+
+		while (head < queue.Num())
+		{
+			const uint32 id = queue[head++];
+			const SVONScheduledRequest* request = myRequests.Find(id);
+
+			// Skip ids that were processed already, or promoted to another queue
+			if (request && (int32)request->myPriority == priority)
+			{
+				oRequestId = id;
+				return true;
+			}
+		}
+
+		queue.Reset();
+		head = 0;
+	}
+
+	return false;
+}
+
+bool SVONPathScheduler::ProcessRequest(SVONScheduledRequest& aRequest, int32 aMaxIterations, float aMaxMilliseconds, int32& oIterations)
+{
+	const bool isNewSearch = !aRequest.mySearch.IsValid();
+	if (isNewSearch)
+	{
+		ASVONVolume* volume = aRequest.myVolume.Get();
+		if (!volume || !volume->IsReadyForNavigation())
+		{
+			return true;
+		}
+
+		aRequest.mySearch = MakeShareable(new SVONScheduledSearch(*volume, aRequest.myKey.mySettings, myDebugPoints));
+	}
+
+	SVONScheduledSearch& search = *aRequest.mySearch;
+	SVONPathFinder& pathFinder = search.myPathFinder;
+	const SVONPathFinderSettings& settings = aRequest.myKey.mySettings;
+
+	// The request's own limits cover the search across every frame it takes
+	const int32 requestIterations = settings.myMaxIterations > 0 ? settings.myMaxIterations - search.myNumIterations : 0;
+	const float requestMilliseconds = settings.myMaxMilliseconds > 0.f ? settings.myMaxMilliseconds - search.myMilliseconds : 0.f;
+	pathFinder.SetSearchLimits(GetTighterLimit(aMaxIterations, requestIterations), GetTighterLimit(aMaxMilliseconds, requestMilliseconds));
+
+	const double startTime = FPlatformTime::Seconds();
+
+	if (isNewSearch)
+	{
+		pathFinder.FindPath(aRequest.myKey.myStart, aRequest.myKey.myTarget, nullptr);
+	}
+	else
+	{
+		pathFinder.ResumePath(nullptr);
+	}
+
+	search.myMilliseconds += (FPlatformTime::Seconds() - startTime) * 1000.0;
+	search.myNumIterations += pathFinder.GetNumIterations();
+	oIterations += pathFinder.GetNumIterations();
+
+	if (pathFinder.GetStatus() != ESVONPathStatus::Partial)
+	{
+		return true;
+	}
+
+	// Stopped by the request's own limits rather than the frame's, so the partial path is all it gets
+	return (settings.myMaxIterations > 0 && search.myNumIterations >= settings.myMaxIterations)
+		|| (settings.myMaxMilliseconds > 0.f && search.myMilliseconds >= settings.myMaxMilliseconds);
+}
+
+void SVONPathScheduler::CompleteRequest(SVONScheduledRequest& aRequest)
+{
+	SVONPath path;
+	ESVONPathStatus status = ESVONPathStatus::Failed;
+
+	if (aRequest.mySearch.IsValid())
+	{
+		const SVONPathFinder& pathFinder = aRequest.mySearch->myPathFinder;
+		status = pathFinder.GetStatus();
+		path = pathFinder.GetPath();
+
+		// Lets go of the volume
+		aRequest.mySearch.Reset();
+	}
+
+	AddLatency((FPlatformTime::Seconds() - aRequest.myQueuedTime) * 1000.0);
+
+	for (FSVONScheduledPathComplete& callback : aRequest.myCallbacks)
+	{
+		callback.ExecuteIfBound(status, path);
+	}
+}
+
+void SVONPathScheduler::AddLatency(float aMilliseconds)
+{
+	if (myLatencies.Num() < SVONLatencySamples)
+	{
+		myLatencies.Add(aMilliseconds);
+	}
+	else
+	{
+		myLatencies[myNextLatency] = aMilliseconds;
+	}
+	myNextLatency = (myNextLatency + 1) % SVONLatencySamples;
+}
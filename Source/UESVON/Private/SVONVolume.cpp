@@ -4,6 +4,8 @@
 #include "Engine/CollisionProfile.h"
 #include "Components/BrushComponent.h"
 #include "DrawDebugHelpers.h"
+#include "SVONNavigationManager.h"
+#include "SVONMortonRange.h"
 #include <chrono>
 
 using namespace std::chrono;
@@ -19,6 +21,7 @@ ASVONVolume::ASVONVolume(const FObjectInitializer& ObjectInitializer)
 
 	FBox bounds = GetComponentsBoundingBox(true);
 	bounds.GetCenterAndExtents(myOrigin, myExtent);
+	CacheTransform();
 }
 
 #if WITH_EDITOR
@@ -45,6 +48,12 @@ void ASVONVolume::OnPostShapeChanged()
 /************************************************************************/
 bool ASVONVolume::Generate()
 {
+	if (myNumPendingQueries.GetValue() > 0)
+	{
+		UE_LOG(UESVON, Warning, TEXT("Can't regenerate while %d path queries are running"), myNumPendingQueries.GetValue());
+		return false;
+	}
+
 	FlushPersistentDebugLines(GetWorld());
 
 	// Get bounds and extent
@@ -59,9 +68,17 @@ bool ASVONVolume::Generate()
 	// Clear data (for now)
 	myBlockedIndices.Empty();
 	myData.myLayers.Empty();
+	myData.myNodeArena.Reset();
+	myData.myLinearOctree.Reset();
+	{
+		FScopeLock lock(&myUnpackedLayersLock);
+		myUnpackedLayers.Empty();
+	}
 
 	myNumLayers = myVoxelPower + 1;
 
+	CacheTransform();
+
 	// Rasterize at Layer 1
 	FirstPassRasterize();
 
@@ -87,6 +104,25 @@ bool ASVONVolume::Generate()
 		BuildNeighbourLinks(i);
 	}
 
+	// The layers are final, pack them for the queries that follow
+	if (!myUseCompactLayout || !myData.myLinearOctree.Build(myData.myLayers))
+	{
+		myData.myNodeArena.Build(myData.myLayers);
+	}
+
+	// Label connected regions, so queries between them can be rejected without a search
+	BuildNavIndices();
+	BuildConnectedComponents();
+	BuildFreeVolumes();
+
+	BuildLandmarks();
+
+	myData.myAbstractGraph.Reset();
+	if (myBuildAbstractGraph && myNumLayers > 1)
+	{
+		myData.myAbstractGraph.Build(*this, FMath::Clamp<int32>(myClusterLayer, 1, myNumLayers - 1));
+	}
+
 	int32 buildTime = (duration_cast<milliseconds>(
 		system_clock::now().time_since_epoch()
 		) - startMs).count();
@@ -95,16 +131,25 @@ bool ASVONVolume::Generate()
 
 	for (int i = 0; i < myNumLayers; i++)
 	{
-		totalNodes += myData.myLayers[i].Num();
+		totalNodes += GetNumNodes(i);
 	}
 
-	int32 totalBytes = sizeof(SVONNode) * totalNodes;
+	// Everything reads the packed nodes from here on, so the generated layers can go
+	const int32 layerBytes = sizeof(SVONNode) * totalNodes;
+	myData.myLayers.Empty();
+
+	int32 totalBytes = (int32)(myData.myNodeArena.GetAllocatedSize() + myData.myLinearOctree.GetAllocatedSize());
 	totalBytes += sizeof(SVONLeafNode) * myData.myLeafNodes.Num();
 
 	UE_LOG(UESVON, Display, TEXT("Generation Time : %d"), buildTime);
 	UE_LOG(UESVON, Display, TEXT("Total Layers-Nodes : %d-%d"), myNumLayers, totalNodes);
 	UE_LOG(UESVON, Display, TEXT("Total Leaf Nodes : %d"), myData.myLeafNodes.Num());
 	UE_LOG(UESVON, Display, TEXT("Total Size (bytes): %d"), totalBytes);
+	UE_LOG(UESVON, Display, TEXT("Generated Layers, freed (bytes): %d"), layerBytes);
+	UE_LOG(UESVON, Display, TEXT("Node Arena (bytes): %d"), (int32)myData.myNodeArena.GetAllocatedSize());
+	UE_LOG(UESVON, Display, TEXT("Compact Layout (bytes): %d"), (int32)myData.myLinearOctree.GetAllocatedSize());
+	UE_LOG(UESVON, Display, TEXT("Connected Components : %d"), myData.myNumComponents);
+	UE_LOG(UESVON, Display, TEXT("Sampling Links : %d"), myData.myComponentLinks.Num());
 
 
 	return true;
@@ -152,24 +197,23 @@ bool ASVONVolume::GetNodePosition(layerindex_t aLayer, mortoncode_t aCode, FVect
 	float voxelSize = GetVoxelSize(aLayer);
 	uint_fast32_t x, y, z;
 	morton3D_64_decode(aCode, x, y, z);
-	oPosition = myOrigin - myExtent + FVector(x * voxelSize, y * voxelSize, z * voxelSize) + FVector(voxelSize * 0.5f);
+	oPosition = myZOrigin + FVector(x * voxelSize, y * voxelSize, z * voxelSize) + FVector(voxelSize * 0.5f);
 	return true;
 }
 
 // Gets the position of a given link. Returns true if the link is open, false if blocked
 bool ASVONVolume::GetLinkPosition(const SVONLink& aLink, FVector& oPosition) const
 {
-	const SVONNode& node = GetLayer(aLink.GetLayerIndex())[aLink.GetNodeIndex()];
-
-	GetNodePosition(aLink.GetLayerIndex(), node.myCode, oPosition);
+	GetNodePosition(aLink.GetLayerIndex(), GetNodeCode(aLink.GetLayerIndex(), aLink.GetNodeIndex()), oPosition);
 	// If this is layer 0, and there are valid children
-	if (aLink.GetLayerIndex() == 0 && node.myFirstChild.IsValid())
+	const SVONLink firstChild = aLink.GetLayerIndex() == 0 ? GetNodeFirstChild(0, aLink.GetNodeIndex()) : SVONLink::GetInvalidLink();
+	if (firstChild.IsValid())
 	{
 		float voxelSize = GetVoxelSize(0);
 		uint_fast32_t x,y,z;
 		morton3D_64_decode(aLink.GetSubnodeIndex(), x,y,z);
 		oPosition += FVector(x * voxelSize * 0.25f, y * voxelSize * 0.25f, z * voxelSize * 0.25f) - FVector(voxelSize * 0.375);
-		const SVONLeafNode& leafNode = GetLeafNode(node.myFirstChild.myNodeIndex);
+		const SVONLeafNode& leafNode = GetLeafNode(firstChild.GetNodeIndex());
 		bool isBlocked = leafNode.GetNode(aLink.GetSubnodeIndex());
 		return !isBlocked;
 	}
@@ -178,134 +222,149 @@ bool ASVONVolume::GetLinkPosition(const SVONLink& aLink, FVector& oPosition) con
 
 bool ASVONVolume::GetIndexForCode(layerindex_t aLayer, mortoncode_t aCode, nodeindex_t& oIndex) const
 {
-	const TArray<SVONNode>& layer = GetLayer(aLayer);
+	// The compact layout has no codes to search, but can follow child links down to it
+	if (myData.myLinearOctree.IsBuilt())
+	{
+		return myData.myLinearOctree.GetIndexForCode(aLayer, aCode, oIndex);
+	}
+
+	// Layers are always rasterized in morton order. Search the packed codes, unless we're still building
+	const SVONNodeArena& arena = myData.myNodeArena;
+	const mortoncode_t* codes = arena.IsBuilt() ? arena.GetCodes(aLayer) : nullptr;
+	const TArray<SVONNode>* layer = codes ? nullptr : &myData.myLayers[aLayer];
 
-	for (int i = 0; i < layer.Num(); i++)
+	int32 low = 0;
+	int32 high = (codes ? arena.GetNumNodes(aLayer) : layer->Num()) - 1;
+	while (low <= high)
 	{
-		if (layer[i].myCode == aCode)
+		const int32 mid = low + (high - low) / 2;
+		const mortoncode_t midCode = codes ? codes[mid] : (*layer)[mid].myCode;
+
+		if (midCode == aCode)
 		{
-			oIndex = i;
+			oIndex = mid;
 			return true;
 		}
+		else if (midCode < aCode)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid - 1;
+		}
 	}
 
 	return false;
 }
 
-const SVONNode& ASVONVolume::GetNode(const SVONLink& aLink) const
-{
-	if (aLink.GetLayerIndex() < 14)
-	{
-		return GetLayer(aLink.GetLayerIndex())[aLink.GetNodeIndex()];
-	}
-	else
-	{
-		return GetLayer(myNumLayers - 1)[0];
-	}
-}
-
 const SVONLeafNode& ASVONVolume::GetLeafNode(nodeindex_t aIndex) const
 {
 	return myData.myLeafNodes[aIndex];
 }
 
 void ASVONVolume::GetLeafNeighbours(const SVONLink& aLink, TArray<SVONLink>& oNeighbours) const
+{
+	for (int i = 0; i < 6; i++)
+	{
+		SVONLink neighbour;
+		if (GetLeafNeighbour(aLink, i, neighbour))
+		{
+			oNeighbours.Add(neighbour);
+		}
+	}
+}
+
+bool ASVONVolume::GetLeafNeighbour(const SVONLink& aLink, int32 aDirection, SVONLink& oNeighbour) const
 {
 	mortoncode_t leafIndex = aLink.GetSubnodeIndex();
-	const SVONNode& node = GetNode(aLink);
-	const SVONLeafNode& leaf = GetLeafNode(node.myFirstChild.GetNodeIndex());
+	const SVONLeafNode& leaf = GetLeafNode(GetNodeFirstChild(0, aLink.GetNodeIndex()).GetNodeIndex());
 
 	// Get our starting co-ordinates
 	uint_fast32_t x = 0, y = 0, z = 0;
 	morton3D_64_decode(leafIndex, x, y, z);
 
-	for (int i = 0; i < 6; i++)
-	{
-		// Need to switch to signed ints
-		int32 sX = x + SVONStatics::dirs[i].X;
-		int32 sY = y + SVONStatics::dirs[i].Y;
-		int32 sZ = z + SVONStatics::dirs[i].Z;
+	// Need to switch to signed ints
+	int32 sX = x + SVONStatics::dirs[aDirection].X;
+	int32 sY = y + SVONStatics::dirs[aDirection].Y;
+	int32 sZ = z + SVONStatics::dirs[aDirection].Z;
 
-		// If the neighbour is in bounds of this leaf node
-		if (sX >= 0 && sX < 4 && sY >= 0 && sY < 4 && sZ >= 0 && sZ < 4)
+	// If the neighbour is in bounds of this leaf node
+	if (sX >= 0 && sX < 4 && sY >= 0 && sY < 4 && sZ >= 0 && sZ < 4)
+	{
+		mortoncode_t thisIndex = morton3D_64_encode(sX, sY, sZ);
+		// If this node is blocked, then no link in this direction
+		if (leaf.GetNode(thisIndex))
 		{
-			mortoncode_t thisIndex = morton3D_64_encode(sX, sY, sZ);
-			// If this node is blocked, then no link in this direction, continue
-			if (leaf.GetNode(thisIndex))
-			{
-				continue;
-			}
-			else // Otherwise, this is a valid link, add it
-			{
-				oNeighbours.Emplace(0, aLink.GetNodeIndex(), thisIndex);
-				continue;
-			}
-			
+			return false;
 		}
-		else // the neighbours is out of bounds, we need to find our neighbour
-		{
-			const SVONLink& neighbourLink = node.myNeighbours[i];
-			const SVONNode& neighbourNode = GetNode(neighbourLink);
 
-			// If the neighbour layer 0 has no leaf nodes, just return it
-			if (!neighbourNode.myFirstChild.IsValid())
-			{
-				oNeighbours.Add(neighbourLink);
-				continue;
-			}
+		// Otherwise, this is a valid link
+		oNeighbour = SVONLink(0, aLink.GetNodeIndex(), thisIndex);
+		return true;
+	}
 
-			const SVONLeafNode& leafNode = GetLeafNode(neighbourNode.myFirstChild.GetNodeIndex());
+	// the neighbours is out of bounds, we need to find our neighbour
+	const SVONLink& neighbourLink = GetNodeNeighbours(0, aLink.GetNodeIndex())[aDirection];
 
-			if (leafNode.IsCompletelyBlocked())
-			{
-				// The leaf node is completely blocked, we don't return it
-				continue;
-			}
-			else // Otherwise, we need to find the correct subnode
-			{
-				if (sX < 0)
-					sX = 3;
-				else if (sX > 3)
-					sX = 0;
-				else if (sY < 0)
-					sY = 3;
-				else if (sY > 3)
-					sY = 0;
-				else if (sZ < 0)
-					sZ = 3;
-				else if (sZ > 3)
-					sZ = 0;
-				//
-				mortoncode_t subNodeCode = morton3D_64_encode(sX, sY, sZ);
-
-				// Only return the neighbour if it isn't blocked!
-				if (!leafNode.GetNode(subNodeCode))
-				{
-					oNeighbours.Emplace(0, neighbourNode.myFirstChild.GetNodeIndex(), subNodeCode);
-				}
-			}
-		}
-			
+	// Edge of the volume, or a completely blocked leaf
+	if (!neighbourLink.IsValid())
+		return false;
+
+	const SVONLink& neighbourChild = GetNodeFirstChild(neighbourLink.GetLayerIndex(), neighbourLink.GetNodeIndex());
+
+	// If the neighbour layer 0 has no leaf nodes, just return it
+	if (!neighbourChild.IsValid())
+	{
+		oNeighbour = neighbourLink;
+		return true;
 	}
 
+	const SVONLeafNode& leafNode = GetLeafNode(neighbourChild.GetNodeIndex());
+
+	// The leaf node is completely blocked, we don't return it
+	if (leafNode.IsCompletelyBlocked())
+		return false;
+
+	// Otherwise, we need to find the correct subnode
+	if (sX < 0)
+		sX = 3;
+	else if (sX > 3)
+		sX = 0;
+	else if (sY < 0)
+		sY = 3;
+	else if (sY > 3)
+		sY = 0;
+	else if (sZ < 0)
+		sZ = 3;
+	else if (sZ > 3)
+		sZ = 0;
+	//
+	mortoncode_t subNodeCode = morton3D_64_encode(sX, sY, sZ);
+
+	// Only return the neighbour if it isn't blocked!
+	if (leafNode.GetNode(subNodeCode))
+		return false;
+
+	oNeighbour = SVONLink(0, neighbourChild.GetNodeIndex(), subNodeCode);
+	return true;
 }
 
 void ASVONVolume::GetNeighbours(const SVONLink& aLink, TArray<SVONLink>& oNeighbours) const
 {
-	const SVONNode& node = GetNode(aLink);
+	const SVONLink* neighbours = aLink.IsValid() ? GetNodeNeighbours(aLink.GetLayerIndex(), aLink.GetNodeIndex()) : GetNodeNeighbours(myNumLayers - 1, 0);
 
 	for (int i = 0; i < 6; i++)
 	{
-		const SVONLink& neighbourLink = node.myNeighbours[i];
+		const SVONLink& neighbourLink = neighbours[i];
 
 		if (!neighbourLink.IsValid())
 			continue;
 
-		
-		const SVONNode& neighbour = GetNode(neighbourLink);
+		const SVONLink& neighbourChild = GetNodeFirstChild(neighbourLink.GetLayerIndex(), neighbourLink.GetNodeIndex());
 
 		// If the neighbour has no children, we just use it
-		if (!neighbour.myFirstChild.IsValid())
+		if (!neighbourChild.IsValid())
 		{
 			oNeighbours.Add(neighbourLink);
 			continue;
@@ -366,12 +425,12 @@ void ASVONVolume::GetNeighbours(const SVONLink& aLink, TArray<SVONLink>& oNeighb
 
 
 		// If the neighbour has children and is a leaf node, we need to add 16 leaf voxels 
-		else if (neighbour.myFirstChild.GetLayerIndex() == 0)
+		else if (neighbourChild.GetLayerIndex() == 0)
 		{
 			for (const nodeindex_t& index : SVONStatics::dirLeafChildOffsets[i])
 			{
 				// This is the link to our first child, we just need to add our offsets
-				SVONLink link = neighbour.myFirstChild;
+				SVONLink link = neighbourChild;
 				if(!GetLeafNode(link.GetNodeIndex()).GetNode(index))
 					oNeighbours.Emplace(link.GetLayerIndex(), link.GetNodeIndex(), index );
 			}
@@ -383,191 +442,1330 @@ void ASVONVolume::GetNeighbours(const SVONLink& aLink, TArray<SVONLink>& oNeighb
 			for (const nodeindex_t& index : SVONStatics::dirChildOffsets[i])
 			{
 				// This is the link to our first child, we just need to add our offsets
-				SVONLink link = neighbour.myFirstChild;
+				SVONLink link = neighbourChild;
 				oNeighbours.Emplace(link.GetLayerIndex(), link.GetNodeIndex() + index, link.GetSubnodeIndex());
 			}
 		}
 	}
 }
 
-float ASVONVolume::GetVoxelSize(layerindex_t aLayer) const
+void ASVONVolume::GetNavNeighbours(const SVONLink& aLink, TArray<SVONLink>& oNeighbours) const
 {
-	return (myExtent.X / FMath::Pow(2, myVoxelPower)) * (FMath::Pow(2.0f, aLayer + 1));
+	if (aLink.GetLayerIndex() == 0 && GetNodeFirstChild(0, aLink.GetNodeIndex()).IsValid())
+	{
+		GetLeafNeighbours(aLink, oNeighbours);
+	}
+	else
+	{
+		GetNeighbours(aLink, oNeighbours);
+	}
 }
 
-
-bool ASVONVolume::IsReadyForNavigation()
+void ASVONVolume::ForEachNavLink(TFunctionRef<void(const SVONLink&)> aFunction) const
 {
-	return myIsReadyForNavigation;
-}
+	for (layerindex_t layerIndex = 0; layerIndex < myNumLayers; layerIndex++)
+	{
+		const int32 numNodes = GetNumNodes(layerIndex);
 
+		for (nodeindex_t i = 0; i < numNodes; i++)
+		{
+			const SVONLink firstChild = layerIndex == 0 ? GetNodeFirstChild(0, i) : SVONLink::GetInvalidLink();
+			if (firstChild.IsValid())
+			{
+				const SVONLeafNode& leaf = GetLeafNode(firstChild.GetNodeIndex());
+				for (subnodeindex_t sub = 0; sub < 64; sub++)
+				{
+					if (!leaf.GetNode(sub))
+					{
+						aFunction(SVONLink(0, i, sub));
+					}
+				}
+			}
+			else
+			{
+				aFunction(SVONLink(layerIndex, i, 0));
+			}
+		}
+	}
+}
 
-int32 ASVONVolume::GetNodesInLayer(layerindex_t aLayer)
+void ASVONVolume::ForEachFreeLink(TFunctionRef<void(const SVONLink&)> aFunction) const
 {
-	return FMath::Pow(FMath::Pow(2, (myVoxelPower - (aLayer))), 3);
+	ForEachNavLink([&](const SVONLink& aLink)
+	{
+		if (aLink.GetLayerIndex() == 0 || !GetNodeFirstChild(aLink.GetLayerIndex(), aLink.GetNodeIndex()).IsValid())
+		{
+			aFunction(aLink);
+		}
+	});
 }
 
-int32 ASVONVolume::GetNodesPerSide(layerindex_t aLayer)
+void ASVONVolume::GetFreeNeighbours(const SVONLink& aLink, TArray<SVONLink>& oNeighbours) const
 {
-	return FMath::Pow(2, (myVoxelPower - (aLayer)));
+	// A leaf subnode's neighbours are already free space
+	if (aLink.GetLayerIndex() == 0 && GetNodeFirstChild(0, aLink.GetNodeIndex()).IsValid())
+	{
+		GetLeafNeighbours(aLink, oNeighbours);
+		return;
+	}
+
+	// A neighbour on a higher layer is only there because the same size node doesn't exist, so it has no children
+	const SVONLink* neighbours = GetNodeNeighbours(aLink.GetLayerIndex(), aLink.GetNodeIndex());
+	for (int32 i = 0; i < 6; i++)
+	{
+		if (neighbours[i].IsValid())
+		{
+			AddFaceFreeLinks(neighbours[i], i, oNeighbours);
+		}
+	}
 }
 
-void ASVONVolume::BeginPlay()
+void ASVONVolume::AddFaceFreeLinks(const SVONLink& aLink, int32 aDirection, TArray<SVONLink>& oLinks) const
 {
-	if (!myIsReadyForNavigation)
+	const SVONLink& firstChild = GetNodeFirstChild(aLink.GetLayerIndex(), aLink.GetNodeIndex());
+	if (!firstChild.IsValid())
 	{
-		Generate();
-		myIsReadyForNavigation = true;
+		oLinks.Add(aLink);
+		return;
+	}
+
+	if (aLink.GetLayerIndex() == 0)
+	{
+		const SVONLeafNode& leaf = GetLeafNode(firstChild.GetNodeIndex());
+		for (const nodeindex_t& index : SVONStatics::dirLeafChildOffsets[aDirection])
+		{
+			if (!leaf.GetNode(index))
+			{
+				oLinks.Emplace(0, aLink.GetNodeIndex(), index);
+			}
+		}
+		return;
+	}
+
+	for (const nodeindex_t& index : SVONStatics::dirChildOffsets[aDirection])
+	{
+		AddFaceFreeLinks(SVONLink(firstChild.GetLayerIndex(), firstChild.GetNodeIndex() + index, 0), aDirection, oLinks);
 	}
 }
 
-void ASVONVolume::PostRegisterAllComponents()
+void ASVONVolume::ForEachFreeLinkInBox(const FBox& aBox, TFunctionRef<void(const SVONLink&)> aFunction) const
 {
-	Super::PostRegisterAllComponents();
+	ForEachFreeLinkInBox(aBox, 0, [](const FBox& aBounds) { return true; }, aFunction);
 }
 
-void ASVONVolume::PostUnregisterAllComponents()
+void ASVONVolume::ForEachFreeLinkInSphere(const FVector& aCentre, float aRadius, TFunctionRef<void(const SVONLink&)> aFunction) const
 {
-	Super::PostUnregisterAllComponents();
+	const float radiusSq = FMath::Square(aRadius);
+
+	ForEachFreeLinkInBox(FBox(aCentre - FVector(aRadius), aCentre + FVector(aRadius)), 0, [&](const FBox& aBounds)
+	{
+		return aBounds.ComputeSquaredDistanceToPoint(aCentre) <= radiusSq;
+	}, aFunction);
 }
 
-void ASVONVolume::BuildNeighbourLinks(layerindex_t aLayer)
+bool ASVONVolume::GetVoxelBox(const FBox& aBox, FIntVector& oMin, FIntVector& oMax) const
 {
+	if (myNumLayers == 0)
+		return false;
+
+	// The box in leaf voxel coordinates, clipped to the volume
+	const int32 numVoxels = GetNodesPerSide(0) * 4;
+	const FVector boxMin = (aBox.Min - myZOrigin) * myInvLeafVoxelSize;
+	const FVector boxMax = (aBox.Max - myZOrigin) * myInvLeafVoxelSize;
+
+	oMin = FIntVector(
+		FMath::Max(FMath::FloorToInt(boxMin.X), 0),
+		FMath::Max(FMath::FloorToInt(boxMin.Y), 0),
+		FMath::Max(FMath::FloorToInt(boxMin.Z), 0));
+	oMax = FIntVector(
+		FMath::Min(FMath::FloorToInt(boxMax.X), numVoxels - 1),
+		FMath::Min(FMath::FloorToInt(boxMax.Y), numVoxels - 1),
+		FMath::Min(FMath::FloorToInt(boxMax.Z), numVoxels - 1));
+
+	return oMin.X <= oMax.X && oMin.Y <= oMax.Y && oMin.Z <= oMax.Z;
+}
 
-	TArray<SVONNode>& layer = GetLayer(aLayer);
-	layerindex_t searchLayer = aLayer;
+void ASVONVolume::ForEachFreeLinkInBox(const FBox& aBox, layerindex_t aMinLayer, TFunctionRef<bool(const FBox&)> aFilter, TFunctionRef<void(const SVONLink&)> aFunction) const
+{
+	FIntVector voxelMin, voxelMax;
+	if (!GetVoxelBox(aBox, voxelMin, voxelMax))
+		return;
 
-	// For each node
-	for (nodeindex_t i = 0; i < layer.Num(); i++)
+	const float leafVoxelSize = GetVoxelSize(0) * 0.25f;
+
+	for (layerindex_t layerIndex = aMinLayer; layerIndex < myNumLayers; layerIndex++)
 	{
-		SVONNode& node = layer[i];
-		// Get our world co-ordinate
-		uint_fast32_t x, y, z;
-		morton3D_64_decode(node.myCode, x, y, z);
-		nodeindex_t backtrackIndex = -1;
-		nodeindex_t index = i;
-		FVector nodePos;
-		GetNodePosition(aLayer, node.myCode, nodePos);
+		// Node coordinates are leaf voxel coordinates shifted down
+		const int32 shift = layerIndex + 2;
+		const FIntVector layerMin(voxelMin.X >> shift, voxelMin.Y >> shift, voxelMin.Z >> shift);
+		const FIntVector layerMax(voxelMax.X >> shift, voxelMax.Y >> shift, voxelMax.Z >> shift);
 
-		// For each direction
-		for (int d = 0; d < 6; d++)
+		ForEachNodeInBox(layerIndex, layerMin, layerMax, 0, GetNumNodes(layerIndex), [&](nodeindex_t aIndex)
 		{
-			SVONLink& linkToUpdate = node.myNeighbours[d];
-
-			backtrackIndex = index;
+			const SVONLink firstChild = GetNodeFirstChild(layerIndex, aIndex);
 
-			while (!FindLinkInDirection(searchLayer, index, d, linkToUpdate, nodePos)
-				&& aLayer < myData.myLayers.Num() - 2)
+			if (!firstChild.IsValid())
 			{
-				SVONLink& parent = GetLayer(searchLayer)[index].myParent;
-				if (parent.IsValid())
+				FVector position;
+				GetNodePosition(layerIndex, GetNodeCode(layerIndex, aIndex), position);
+				const FVector extent(GetVoxelSize(layerIndex) * 0.5f);
+
+				if (aFilter(FBox(position - extent, position + extent)))
 				{
-					index = parent.myNodeIndex;
-					searchLayer = parent.myLayerIndex;
+					aFunction(SVONLink(layerIndex, aIndex, 0));
 				}
-				else
+				return;
+			}
+
+			// Nodes with children are covered by the layer below
+			if (layerIndex != 0)
+				return;
+
+			const SVONLeafNode& leaf = GetLeafNode(firstChild.GetNodeIndex());
+			if (leaf.IsCompletelyBlocked())
+				return;
+
+			// Only visit the part of the leaf's 4x4x4 grid that's in the box
+			uint_fast32_t x = 0, y = 0, z = 0;
+			morton3D_64_decode(GetNodeCode(0, aIndex), x, y, z);
+			const FIntVector leafOrigin(x * 4, y * 4, z * 4);
+
+			const FIntVector localMin(FMath::Max(voxelMin.X - leafOrigin.X, 0), FMath::Max(voxelMin.Y - leafOrigin.Y, 0), FMath::Max(voxelMin.Z - leafOrigin.Z, 0));
+			const FIntVector localMax(FMath::Min(voxelMax.X - leafOrigin.X, 3), FMath::Min(voxelMax.Y - leafOrigin.Y, 3), FMath::Min(voxelMax.Z - leafOrigin.Z, 3));
+
+			for (int32 lz = localMin.Z; lz <= localMax.Z; lz++)
+			for (int32 ly = localMin.Y; ly <= localMax.Y; ly++)
+			for (int32 lx = localMin.X; lx <= localMax.X; lx++)
+			{
+				const mortoncode_t subnode = morton3D_64_encode(lx, ly, lz);
+				if (leaf.GetNode(subnode))
+					continue;
+
+				const SVONLink link(0, aIndex, subnode);
+				FVector position;
+				GetLinkPosition(link, position);
+				const FVector extent(leafVoxelSize * 0.5f);
+
+				if (aFilter(FBox(position - extent, position + extent)))
 				{
-					searchLayer++;
-					GetIndexForCode(searchLayer, node.myCode >> 3, index);
+					aFunction(link);
 				}
-
 			}
-			index = backtrackIndex;
-			searchLayer = aLayer;
-		}
+		});
 	}
 }
 
-bool ASVONVolume::FindLinkInDirection(layerindex_t aLayer, const nodeindex_t aNodeIndex, uint8 aDir, SVONLink& oLinkToUpdate, FVector& aStartPosForDebug)
+/* First index in [aFirst, aLast) of a layer's sorted codes with a code of at least aCode */
+template<typename CodeGetter>
+static int32 LowerBoundCode(const CodeGetter& aGetCode, int32 aFirst, int32 aLast, mortoncode_t aCode)
 {
-	int32 maxCoord = GetNodesPerSide(aLayer);
-	SVONNode& node = GetLayer(aLayer)[aNodeIndex];
-	TArray<SVONNode>& layer = GetLayer(aLayer);
-
-	// Get our world co-ordinate
-	uint_fast32_t x = 0, y = 0, z = 0;
-	morton3D_64_decode(node.myCode, x, y, z);
-	int32 sX = x, sY = y, sZ = z;
-	// Add the direction
-	sX += SVONStatics::dirs[aDir].X;
-	sY += SVONStatics::dirs[aDir].Y;
-	sZ += SVONStatics::dirs[aDir].Z;
+	while (aFirst < aLast)
+	{
+		const int32 mid = aFirst + (aLast - aFirst) / 2;
+		if (aGetCode(mid) < aCode)
+		{
+			aFirst = mid + 1;
+		}
+		else
+		{
+			aLast = mid;
+		}
+	}
+	return aFirst;
+}
 
-	// If the coords are out of bounds, the link is invalid.
-	if (sX < 0 || sX >= maxCoord || sY < 0 || sY >= maxCoord || sZ < 0 || sZ >= maxCoord)
+void ASVONVolume::ForEachNodeInBox(layerindex_t aLayer, const FIntVector& aMin, const FIntVector& aMax, int32 aFirst, int32 aLast, TFunctionRef<void(nodeindex_t)> aFunction) const
+{
+	ForEachIntervalInBox(aLayer, aMin, aMax, aFirst, aLast, [&](int32 aIntervalFirst, int32 aIntervalLast)
 	{
-		oLinkToUpdate.SetInvalid();
-		if (myShowNeighbourLinks)
+		for (int32 i = aIntervalFirst; i < aIntervalLast; i++)
 		{
-			FVector startPos, endPos;
-			GetNodePosition(aLayer, node.myCode, startPos);
-			endPos = startPos + (FVector(SVONStatics::dirs[aDir]) * 100.f);
-			DrawDebugLine(GetWorld(), aStartPosForDebug, endPos, FColor::Red, true, -1.f, 0, .0f);
+			aFunction(i);
 		}
-		return true;
+	});
+}
+
+void ASVONVolume::ForEachIntervalInBox(layerindex_t aLayer, const FIntVector& aMin, const FIntVector& aMax, int32 aFirst, int32 aLast, TFunctionRef<void(int32, int32)> aFunction) const
+{
+	// Packed codes if we have them, the compact layout doesn't store any
+	const mortoncode_t* codes = myData.myNodeArena.IsBuilt() ? myData.myNodeArena.GetCodes(aLayer) : nullptr;
+	auto GetCode = [&](int32 aIndex) { return codes ? codes[aIndex] : GetNodeCode(aLayer, aIndex); };
+
+	// Narrow down to the nodes with codes between the corners' codes
+	const int32 first = LowerBoundCode(GetCode, aFirst, aLast, morton3D_64_encode(aMin.X, aMin.Y, aMin.Z));
+	const int32 last = LowerBoundCode(GetCode, first, aLast, morton3D_64_encode(aMax.X, aMax.Y, aMax.Z) + 1);
+
+	if (first >= last)
+		return;
+
+	// One unbroken interval of codes
+	if (SVONMortonRange::IsContiguous(aMin, aMax))
+	{
+		aFunction(first, last);
+		return;
 	}
-	x = sX; y = sY; z = sZ;
-	// Get the morton code for the direction
-	mortoncode_t thisCode = morton3D_64_encode(x, y, z);
-	bool isHigher = thisCode > node.myCode;
-	int32 nodeDelta = (isHigher ?  1 : - 1);
 
-	while ((aNodeIndex + nodeDelta) < layer.Num() && aNodeIndex + nodeDelta >= 0)
+	// Few enough nodes that checking each beats splitting further. Runs of them inside the box are intervals
+	if (last - first <= 8)
 	{
-		// This is the node we're looking for
-		if (layer[aNodeIndex + nodeDelta].myCode == thisCode)
+		int32 runFirst = INDEX_NONE;
+		for (int32 i = first; i < last; i++)
 		{
-			const SVONNode& thisNode = layer[aNodeIndex + nodeDelta];
-			// This is a leaf node
-			if (aLayer == 0 && thisNode.HasChildren())
+			if (SVONMortonRange::IsInBox(GetCode(i), aMin, aMax))
 			{
-				// Set invalid link if the leaf node is completely blocked, no point linking to it
-				if (GetLeafNode(thisNode.myFirstChild.GetNodeIndex()).IsCompletelyBlocked())
-				{
-					oLinkToUpdate.SetInvalid();
-					return true;
-				}
+				runFirst = runFirst == INDEX_NONE ? i : runFirst;
 			}
-			// Otherwise, use this link
-			oLinkToUpdate.myLayerIndex = aLayer;
-			check(aNodeIndex + nodeDelta < layer.Num());
-			oLinkToUpdate.myNodeIndex = aNodeIndex + nodeDelta;
-			if (myShowNeighbourLinks)
+			else if (runFirst != INDEX_NONE)
 			{
-				FVector endPos;
-				GetNodePosition(aLayer, thisCode, endPos);
-				DrawDebugLine(GetWorld(), aStartPosForDebug, endPos, SVONStatics::myLinkColors[aLayer], true, -1.f, 0, .0f);
+				aFunction(runFirst, i);
+				runFirst = INDEX_NONE;
 			}
-			return true;
 		}
-		// If we've passed the code we're looking for, it's not on this layer
-		else if ((isHigher && layer[aNodeIndex + nodeDelta].myCode > thisCode) || (!isHigher && layer[aNodeIndex + nodeDelta].myCode < thisCode))
+
+		if (runFirst != INDEX_NONE)
 		{
-			return false;
+			aFunction(runFirst, last);
 		}
-
-		nodeDelta += (isHigher ? 1 : -1);
+		return;
 	}
 
+	// Skip the run of codes between LITMAX and BIGMIN, which is all outside the box
+	FIntVector litMax, bigMin;
+	SVONMortonRange::SplitBox(aMin, aMax, litMax, bigMin);
 
-
-	// I'm not entirely sure if it's valid to reach the end? Hmmm...
-	return false;
-
+	ForEachIntervalInBox(aLayer, aMin, litMax, first, last, aFunction);
+	ForEachIntervalInBox(aLayer, bigMin, aMax, first, last, aFunction);
 }
 
-void ASVONVolume::RasterizeLeafNode(FVector& aOrigin, nodeindex_t aLeafIndex)
+int32 ASVONVolume::GetNavIndex(const SVONLink& aLink) const
 {
-	for (int i = 0; i < 64; i++)
+	if (!aLink.IsValid() || aLink.GetLayerIndex() >= myData.myLayerNavOffsets.Num())
 	{
+		return INDEX_NONE;
+	}
 
-		uint_fast32_t x, y, z;
-		morton3D_64_decode(i, x, y, z);
-		float leafVoxelSize = GetVoxelSize(0) * 0.25f;
-		FVector position = aOrigin + FVector(x * leafVoxelSize, y * leafVoxelSize, z * leafVoxelSize) + FVector(leafVoxelSize * 0.5f);
-
-		if (aLeafIndex >= myData.myLeafNodes.Num() - 1)
-			myData.myLeafNodes.AddDefaulted(1);
+	const SVONLink firstChild = aLink.GetLayerIndex() == 0 ? GetNodeFirstChild(0, aLink.GetNodeIndex()) : SVONLink::GetInvalidLink();
+
+	if (firstChild.IsValid())
+	{
+		return myData.myLeafNavOffset + firstChild.GetNodeIndex() * 64 + aLink.GetSubnodeIndex();
+	}
+
+	return myData.myLayerNavOffsets[aLink.GetLayerIndex()] + aLink.GetNodeIndex();
+}
+
+int32 ASVONVolume::GetComponent(const SVONLink& aLink) const
+{
+	const int32 navIndex = GetNavIndex(aLink);
+	return myData.myComponents.IsValidIndex(navIndex) ? myData.myComponents[navIndex] : INDEX_NONE;
+}
+
+/* Random number in [0, aMax), from two 32 bit draws as volumes can be past 32 bits */
+static uint64 GetRandomVolume(FRandomStream& aRandom, uint64 aMax)
+{
+	const uint64 value = ((uint64)aRandom.GetUnsignedInt() << 32) | aRandom.GetUnsignedInt();
+	return value % aMax;
+}
+
+/* First index in [aFirst, aLast) whose running total is past aValue */
+template<typename T>
+static int32 FindRunningTotal(const TArray<T>& aTotals, int32 aFirst, int32 aLast, T aValue)
+{
+	while (aFirst < aLast)
+	{
+		const int32 mid = aFirst + (aLast - aFirst) / 2;
+		if (aTotals[mid] <= aValue)
+		{
+			aFirst = mid + 1;
+		}
+		else
+		{
+			aLast = mid;
+		}
+	}
+	return aFirst;
+}
+
+bool ASVONVolume::GetRandomNavigablePoint(FRandomStream& aRandom, FVector& oPosition, int32 aComponent) const
+{
+	if (aComponent != INDEX_NONE)
+	{
+		if (!myData.myComponentOffsets.IsValidIndex(aComponent + 1))
+			return false;
+
+		const int32 first = myData.myComponentOffsets[aComponent];
+		const int32 last = myData.myComponentOffsets[aComponent + 1];
+		if (first == last)
+			return false;
+
+		const uint64 value = GetRandomVolume(aRandom, myData.myComponentFreeVolumes[last - 1]);
+		const int32 index = FindRunningTotal(myData.myComponentFreeVolumes, first, last, value);
+
+		oPosition = GetRandomPointInLink(myData.myComponentLinks[index], aRandom);
+		return true;
+	}
+
+	if (myData.myTotalFreeVolume == 0)
+		return false;
+
+	// Pick a layer by its share of the free volume, then a node within it
+	uint64 value = GetRandomVolume(aRandom, myData.myTotalFreeVolume);
+	for (layerindex_t layerIndex = 0; layerIndex < myData.myLayerFreeVolumes.Num(); layerIndex++)
+	{
+		const TArray<uint64>& layer = myData.myLayerFreeVolumes[layerIndex];
+		const uint64 layerVolume = layer.Num() > 0 ? layer.Last() : 0;
+		if (value >= layerVolume)
+		{
+			value -= layerVolume;
+			continue;
+		}
+
+		oPosition = GetRandomPointInLink(GetLinkForFreeVolume(layerIndex, 0, layer.Num(), value), aRandom);
+		return true;
+	}
+
+	return false;
+}
+
+SVONLink ASVONVolume::GetLinkForFreeVolume(layerindex_t aLayer, int32 aFirst, int32 aLast, uint64 aValue) const
+{
+	const TArray<uint64>& totals = myData.myLayerFreeVolumes[aLayer];
+	const int32 index = FindRunningTotal(totals, aFirst, aLast, aValue);
+	SVONLink link(aLayer, index, 0);
+
+	// In a leaf node, the rest of the value picks which of its free subnodes
+	const SVONLink firstChild = GetNodeFirstChild(aLayer, index);
+	if (aLayer == 0 && firstChild.IsValid())
+	{
+		uint64 offset = aValue - (index > 0 ? totals[index - 1] : 0);
+		const SVONLeafNode& leaf = GetLeafNode(firstChild.GetNodeIndex());
+		for (mortoncode_t i = 0; i < 64; i++)
+		{
+			if (!leaf.GetNode(i) && offset-- == 0)
+			{
+				link.SetSubnodeIndex(i);
+				break;
+			}
+		}
+	}
+
+	return link;
+}
+
+int32 ASVONVolume::GetRandomNavigablePoints(int32 aNumPoints, FRandomStream& aRandom, TArray<FVector>& oPositions, int32 aComponent) const
+{
+	oPositions.Reserve(oPositions.Num() + aNumPoints);
+
+	int32 numAdded = 0;
+	FVector position;
+	for (int32 i = 0; i < aNumPoints; i++)
+	{
+		if (!GetRandomNavigablePoint(aRandom, position, aComponent))
+			break;
+
+		oPositions.Add(position);
+		numAdded++;
+	}
+	return numAdded;
+}
+
+/* Part of the free space around a sphere to sample from: a run of a layer's nodes, or one link clipped to the sphere's bounds */
+struct SVONSampleRegion
+{
+	SVONLink myLink;
+	FBox myBox;
+	layerindex_t myLayer;
+	int32 myFirst;
+	int32 myLast;
+	// The run's free volume, and the running total before it, in leaf voxels
+	uint64 myVolumeBefore;
+	uint64 myVolume;
+};
+
+int32 ASVONVolume::GetRandomNavigablePointsInRadius(const FVector& aCentre, float aRadius, int32 aNumPoints, FRandomStream& aRandom, TArray<FVector>& oPositions, int32 aComponent) const
+{
+	const FBox sphereBounds(aCentre - FVector(aRadius), aCentre + FVector(aRadius));
+	FIntVector voxelMin, voxelMax;
+	if (aNumPoints <= 0 || !GetVoxelBox(sphereBounds, voxelMin, voxelMax))
+		return 0;
+
+	// Nodes up to a quarter of the bounds across are weighted by the free volume running totals, over the morton intervals
+	// of each layer the bounds cover. Enough of those draws land in the sphere to reject the rest.
+	// Bigger nodes are few, and can be far bigger than the sphere, so they're clipped to its bounds and weighted by what's left
+	const FIntVector boundsSize = voxelMax - voxelMin + FIntVector(1);
+	const int32 boundsVoxels = FMath::Min3(boundsSize.X, boundsSize.Y, boundsSize.Z);
+
+	layerindex_t firstClippedLayer = 0;
+	while (firstClippedLayer < myNumLayers && (16 << firstClippedLayer) <= boundsVoxels)
+	{
+		firstClippedLayer++;
+	}
+
+	const float leafVoxelSize = GetVoxelSize(0) * 0.25f;
+	const double leafVoxelVolume = (double)leafVoxelSize * leafVoxelSize * leafVoxelSize;
+
+	TArray<SVONSampleRegion> regions;
+	TArray<double> totals;
+	double totalVolume = 0.0;
+
+	for (layerindex_t layerIndex = 0; layerIndex < firstClippedLayer; layerIndex++)
+	{
+		const TArray<uint64>& layerTotals = myData.myLayerFreeVolumes[layerIndex];
+		const int32 shift = layerIndex + 2;
+		const FIntVector layerMin(voxelMin.X >> shift, voxelMin.Y >> shift, voxelMin.Z >> shift);
+		const FIntVector layerMax(voxelMax.X >> shift, voxelMax.Y >> shift, voxelMax.Z >> shift);
+
+		ForEachIntervalInBox(layerIndex, layerMin, layerMax, 0, GetNumNodes(layerIndex), [&](int32 aFirst, int32 aLast)
+		{
+			const uint64 before = aFirst > 0 ? layerTotals[aFirst - 1] : 0;
+			const uint64 volume = layerTotals[aLast - 1] - before;
+			if (volume == 0)
+				return;
+
+			totalVolume += volume * leafVoxelVolume;
+			regions.Add({ SVONLink::GetInvalidLink(), FBox(ForceInit), layerIndex, aFirst, aLast, before, volume });
+			totals.Add(totalVolume);
+		});
+	}
+
+	const float radiusSq = FMath::Square(aRadius);
+
+	ForEachFreeLinkInBox(sphereBounds, firstClippedLayer, [&](const FBox& aBounds)
+	{
+		return aBounds.ComputeSquaredDistanceToPoint(aCentre) <= radiusSq;
+	}, [&](const SVONLink& aLink)
+	{
+		if (aComponent != INDEX_NONE && GetComponent(aLink) != aComponent)
+			return;
+
+		const FBox box = GetLinkBounds(aLink).Overlap(sphereBounds);
+		const FVector size = box.GetSize();
+		const double volume = (double)size.X * size.Y * size.Z;
+		if (volume <= 0.0)
+			return;
+
+		totalVolume += volume;
+		regions.Add({ aLink, box, 0, 0, 0, 0, 0 });
+		totals.Add(totalVolume);
+	});
+
+	if (regions.Num() == 0)
+		return 0;
+
+	oPositions.Reserve(oPositions.Num() + aNumPoints);
+
+	// Draws outside the sphere, or in another component, are rejected. That can't be ruled out up front, as free space can be
+	// anywhere in the regions, so the draws are capped and we return how many points we got
+	const int32 maxAttempts = aNumPoints * 32;
+
+	int32 numAdded = 0;
+	for (int32 attempt = 0; attempt < maxAttempts && numAdded < aNumPoints; attempt++)
+	{
+		const double value = aRandom.GetFraction() * totalVolume;
+		const SVONSampleRegion& region = regions[FMath::Min(FindRunningTotal(totals, 0, totals.Num(), value), regions.Num() - 1)];
+
+		FVector position;
+		if (region.myLink.IsValid())
+		{
+			position = FVector(
+				aRandom.FRandRange(region.myBox.Min.X, region.myBox.Max.X),
+				aRandom.FRandRange(region.myBox.Min.Y, region.myBox.Max.Y),
+				aRandom.FRandRange(region.myBox.Min.Z, region.myBox.Max.Z));
+		}
+		else
+		{
+			const SVONLink link = GetLinkForFreeVolume(region.myLayer, region.myFirst, region.myLast, region.myVolumeBefore + GetRandomVolume(aRandom, region.myVolume));
+			if (aComponent != INDEX_NONE && GetComponent(link) != aComponent)
+				continue;
+
+			position = GetRandomPointInLink(link, aRandom);
+		}
+
+		if (FVector::DistSquared(position, aCentre) > radiusSq)
+			continue;
+
+		oPositions.Add(position);
+		numAdded++;
+	}
+
+	if (numAdded < aNumPoints)
+	{
+		UE_LOG(UESVON, Verbose, TEXT("Only found %d of %d random points in radius %f"), numAdded, aNumPoints, aRadius);
+	}
+	return numAdded;
+}
+
+FBox ASVONVolume::GetLinkBounds(const SVONLink& aLink) const
+{
+	FVector position;
+	GetLinkPosition(aLink, position);
+
+	const bool isSubnode = aLink.GetLayerIndex() == 0 && GetNodeFirstChild(0, aLink.GetNodeIndex()).IsValid();
+	const float extent = GetVoxelSize(aLink.GetLayerIndex()) * (isSubnode ? 0.125f : 0.5f);
+
+	return FBox(position - FVector(extent), position + FVector(extent));
+}
+
+uint64 ASVONVolume::GetLinkFreeVolume(const SVONLink& aLink) const
+{
+	const SVONLink firstChild = GetNodeFirstChild(aLink.GetLayerIndex(), aLink.GetNodeIndex());
+
+	if (!firstChild.IsValid())
+	{
+		// A layer 0 node is 64 leaf voxels, and each layer up is 8 times that
+		return 64ull << (3 * aLink.GetLayerIndex());
+	}
+
+	if (aLink.GetLayerIndex() == 0)
+	{
+		return GetLeafNode(firstChild.GetNodeIndex()).GetNode(aLink.GetSubnodeIndex()) ? 0 : 1;
+	}
+
+	return 0;
+}
+
+FVector ASVONVolume::GetRandomPointInLink(const SVONLink& aLink, FRandomStream& aRandom) const
+{
+	const FBox box = GetLinkBounds(aLink);
+	return FVector(
+		aRandom.FRandRange(box.Min.X, box.Max.X),
+		aRandom.FRandRange(box.Min.Y, box.Max.Y),
+		aRandom.FRandRange(box.Min.Z, box.Max.Z));
+}
+
+bool ASVONVolume::AreLinksConnected(const SVONLink& aStart, const SVONLink& aTarget) const
+{
+	const int32 startComponent = GetComponent(aStart);
+	const int32 targetComponent = GetComponent(aTarget);
+
+	// No labels, we can't rule it out
+	if (startComponent == INDEX_NONE || targetComponent == INDEX_NONE)
+	{
+		return true;
+	}
+
+	return startComponent == targetComponent;
+}
+
+bool ASVONVolume::IsPositionBlocked(const FVector& aPosition) const
+{
+	FIntVector voxel;
+	SVONLink link;
+	return !GetVoxelCoordinate(aPosition, voxel) || !GetLinkForVoxel(voxel, link);
+}
+
+bool ASVONVolume::HasLineOfSight(const FVector& aStart, const FVector& aEnd) const
+{
+	SVONRaycastHit hit;
+	return !Raycast(aStart, aEnd, hit);
+}
+
+bool ASVONVolume::GetVoxelCoordinate(const FVector& aPosition, FIntVector& oVoxel) const
+{
+	if (myNumLayers == 0)
+		return false;
+
+	const FVector voxelPos = (aPosition - myZOrigin) * myInvLeafVoxelSize;
+	const int32 numVoxels = GetNodesPerSide(0) * 4;
+
+	oVoxel.X = FMath::FloorToInt(voxelPos.X);
+	oVoxel.Y = FMath::FloorToInt(voxelPos.Y);
+	oVoxel.Z = FMath::FloorToInt(voxelPos.Z);
+
+	return oVoxel.X >= 0 && oVoxel.Y >= 0 && oVoxel.Z >= 0 && oVoxel.X < numVoxels && oVoxel.Y < numVoxels && oVoxel.Z < numVoxels;
+}
+
+bool ASVONVolume::GetLinkForVoxel(const FIntVector& aVoxel, SVONLink& oLink) const
+{
+	const int32 numVoxels = GetNodesPerSide(0) * 4;
+	if (myNumLayers == 0 || aVoxel.X < 0 || aVoxel.Y < 0 || aVoxel.Z < 0 || aVoxel.X >= numVoxels || aVoxel.Y >= numVoxels || aVoxel.Z >= numVoxels)
+		return false;
+
+	const layerindex_t layer = myNumLayers - 1;
+	nodeindex_t index = 0;
+	if (!GetIndexForCode(layer, morton3D_64_encode(aVoxel.X, aVoxel.Y, aVoxel.Z) >> (3 * (layer + 2)), index))
+		return false;
+
+	return GetLinkForVoxelFromNode(layer, index, aVoxel, oLink);
+}
+
+bool ASVONVolume::NodeContainsVoxel(layerindex_t aLayer, nodeindex_t aNodeIndex, const FIntVector& aVoxel) const
+{
+	if (aLayer >= myNumLayers || aNodeIndex < 0 || aNodeIndex >= GetNumNodes(aLayer))
+		return false;
+
+	// Node codes are the leaf voxel code with the bottom 3 * (layer + 2) bits dropped
+	const mortoncode_t code = morton3D_64_encode(aVoxel.X, aVoxel.Y, aVoxel.Z) >> (3 * (aLayer + 2));
+
+	// The compact layout works codes out from the parent chain. Descending to the voxel's node by child indices is cheaper
+	if (myData.myLinearOctree.IsBuilt())
+	{
+		nodeindex_t index = 0;
+		return myData.myLinearOctree.GetIndexForCode(aLayer, code, index) && index == aNodeIndex;
+	}
+
+	return GetNodeCode(aLayer, aNodeIndex) == code;
+}
+
+bool ASVONVolume::GetLinkForVoxelFromNode(layerindex_t aLayer, nodeindex_t aNodeIndex, const FIntVector& aVoxel, SVONLink& oLink) const
+{
+	// Code at leaf voxel resolution, each layer's code is just a shift of it
+	const mortoncode_t code = morton3D_64_encode(aVoxel.X, aVoxel.Y, aVoxel.Z);
+
+	layerindex_t layer = aLayer;
+	nodeindex_t index = aNodeIndex;
+
+	while (true)
+	{
+		const SVONLink& firstChild = GetNodeFirstChild(layer, index);
+
+		// No children, so this whole node is free
+		if (!firstChild.IsValid())
+		{
+			oLink = SVONLink(layer, index, 0);
+			return true;
+		}
+
+		if (layer == 0)
+		{
+			const mortoncode_t subnode = code & 63;
+			if (GetLeafNode(firstChild.GetNodeIndex()).GetNode(subnode))
+				return false;
+
+			oLink = SVONLink(0, index, subnode);
+			return true;
+		}
+
+		// Children are stored as 8 siblings in code order
+		layer--;
+		index = firstChild.GetNodeIndex() + ((code >> (3 * (layer + 2))) & 7);
+	}
+}
+
+bool ASVONVolume::Raycast(const FVector& aStart, const FVector& aEnd, SVONRaycastHit& oHit) const
+{
+	if (myNumLayers == 0)
+		return false;
+
+	// Work in leaf voxel units from the volume's min corner, so node boundaries are whole numbers
+	const int32 numVoxels = GetNodesPerSide(0) * 4;
+	const FVector start = (aStart - myZOrigin) * myInvLeafVoxelSize;
+	const FVector delta = (aEnd - aStart) * myInvLeafVoxelSize;
+
+	// Clip the segment to the volume
+	float tMin = 0.f;
+	float tMax = 1.f;
+	for (int32 axis = 0; axis < 3; axis++)
+	{
+		if (delta[axis] == 0.f)
+		{
+			if (start[axis] < 0.f || start[axis] >= numVoxels)
+				return false;
+			continue;
+		}
+
+		float t0 = -start[axis] / delta[axis];
+		float t1 = (numVoxels - start[axis]) / delta[axis];
+		if (t0 > t1)
+			Swap(t0, t1);
+
+		tMin = FMath::Max(tMin, t0);
+		tMax = FMath::Min(tMax, t1);
+	}
+
+	if (tMin > tMax)
+		return false;
+
+	// The voxel we enter first. Sitting on a boundary, moving backwards, we're in the voxel behind it
+	FIntVector voxel;
+	const FVector entry = start + delta * tMin;
+	for (int32 axis = 0; axis < 3; axis++)
+	{
+		voxel[axis] = FMath::FloorToInt(entry[axis]);
+		if (delta[axis] < 0.f && voxel[axis] == entry[axis])
+			voxel[axis]--;
+		voxel[axis] = FMath::Clamp(voxel[axis], 0, numVoxels - 1);
+	}
+
+	float t = tMin;
+
+	while (true)
+	{
+		SVONLink link;
+		if (!GetLinkForVoxel(voxel, link))
+		{
+			oHit.myPosition = aStart + (aEnd - aStart) * t;
+			oHit.myVoxel = voxel;
+			oHit.myTime = t;
+			return true;
+		}
+
+		// The free cube we're in, in leaf voxels. We step over all of it at once
+		const int32 size = (link.GetLayerIndex() == 0 && GetNodeFirstChild(0, link.GetNodeIndex()).IsValid()) ? 1 : 4 << link.GetLayerIndex();
+		const FIntVector base(voxel.X & ~(size - 1), voxel.Y & ~(size - 1), voxel.Z & ~(size - 1));
+
+		float tAxis[3];
+		float tExit = FLT_MAX;
+		for (int32 axis = 0; axis < 3; axis++)
+		{
+			if (delta[axis] > 0.f)
+				tAxis[axis] = (base[axis] + size - start[axis]) / delta[axis];
+			else if (delta[axis] < 0.f)
+				tAxis[axis] = (base[axis] - start[axis]) / delta[axis];
+			else
+				tAxis[axis] = FLT_MAX;
+
+			tExit = FMath::Min(tExit, tAxis[axis]);
+		}
+
+		// The segment ends inside this cube
+		if (tExit >= tMax)
+			return false;
+
+		// Step into the next voxel in integers, on every axis we leave through at once (edges and corners)
+		const FVector exitPoint = start + delta * tExit;
+		for (int32 axis = 0; axis < 3; axis++)
+		{
+			if (tAxis[axis] <= tExit + SMALL_NUMBER)
+				voxel[axis] = delta[axis] > 0.f ? base[axis] + size : base[axis] - 1;
+			else
+				voxel[axis] = FMath::Clamp(FMath::FloorToInt(exitPoint[axis]), base[axis], base[axis] + size - 1);
+
+			if (voxel[axis] < 0 || voxel[axis] >= numVoxels)
+				return false;
+		}
+
+		t = tExit;
+	}
+}
+
+void ASVONVolume::BuildNavIndices()
+{
+	myData.myLayerNavOffsets.Reset();
+
+	int32 offset = 0;
+	for (int i = 0; i < myNumLayers; i++)
+	{
+		myData.myLayerNavOffsets.Add(offset);
+		offset += GetNumNodes(i);
+	}
+
+	myData.myLeafNavOffset = offset;
+	myData.myNumNavIndices = offset + myData.myLeafNodes.Num() * 64;
+}
+
+// Union-find root lookup, with path halving
+static int32 FindComponentRoot(TArray<int32>& aParents, int32 aIndex)
+{
+	while (aParents[aIndex] != aIndex)
+	{
+		aParents[aIndex] = aParents[aParents[aIndex]];
+		aIndex = aParents[aIndex];
+	}
+	return aIndex;
+}
+
+void ASVONVolume::BuildConnectedComponents()
+{
+	TArray<int32> parents;
+	parents.SetNumUninitialized(myData.myNumNavIndices);
+	for (int32 i = 0; i < parents.Num(); i++)
+	{
+		parents[i] = i;
+	}
+
+	TBitArray<> isNavigable(false, myData.myNumNavIndices);
+	TArray<SVONLink> neighbours;
+
+	// Union every free link with the free space across its faces. Nodes with children span blocked space, so joining through them
+	// would merge regions a wall separates
+	ForEachFreeLink([&](const SVONLink& aLink)
+	{
+		const int32 index = GetNavIndex(aLink);
+		isNavigable[index] = true;
+
+		neighbours.Reset();
+		GetFreeNeighbours(aLink, neighbours);
+
+		for (const SVONLink& neighbour : neighbours)
+		{
+			const int32 neighbourIndex = GetNavIndex(neighbour);
+			if (neighbourIndex == INDEX_NONE)
+				continue;
+
+			const int32 rootA = FindComponentRoot(parents, index);
+			const int32 rootB = FindComponentRoot(parents, neighbourIndex);
+			if (rootA != rootB)
+			{
+				parents[FMath::Max(rootA, rootB)] = FMath::Min(rootA, rootB);
+			}
+		}
+	});
+
+	// Compact the roots down to sequential labels
+	myData.myComponents.Init(INDEX_NONE, myData.myNumNavIndices);
+	myData.myNumComponents = 0;
+
+	for (int32 i = 0; i < myData.myNumNavIndices; i++)
+	{
+		if (!isNavigable[i])
+			continue;
+
+		const int32 root = FindComponentRoot(parents, i);
+		if (myData.myComponents[root] == INDEX_NONE)
+		{
+			myData.myComponents[root] = myData.myNumComponents++;
+		}
+		myData.myComponents[i] = myData.myComponents[root];
+	}
+}
+
+void ASVONVolume::BuildFreeVolumes()
+{
+	// Per layer running totals, in leaf voxels so they're exact
+	myData.myLayerFreeVolumes.Reset();
+	myData.myLayerFreeVolumes.SetNum(myNumLayers);
+	myData.myTotalFreeVolume = 0;
+
+	for (layerindex_t layerIndex = 0; layerIndex < myNumLayers; layerIndex++)
+	{
+		const int32 numNodes = GetNumNodes(layerIndex);
+		TArray<uint64>& totals = myData.myLayerFreeVolumes[layerIndex];
+		totals.SetNumUninitialized(numNodes);
+
+		uint64 total = 0;
+		for (int32 i = 0; i < numNodes; i++)
+		{
+			const SVONLink firstChild = GetNodeFirstChild(layerIndex, i);
+			if (!firstChild.IsValid())
+			{
+				total += 64ull << (3 * layerIndex);
+			}
+			else if (layerIndex == 0)
+			{
+				total += 64 - FMath::CountBits(GetLeafNode(firstChild.GetNodeIndex()).myVoxelGrid);
+			}
+			totals[i] = total;
+		}
+		myData.myTotalFreeVolume += total;
+	}
+
+	// Bucket the free links by component, so sampling one component is a search over its own totals
+	myData.myComponentOffsets.Reset();
+	myData.myComponentOffsets.AddZeroed(myData.myNumComponents + 1);
+
+	ForEachNavLink([&](const SVONLink& aLink)
+	{
+		const int32 component = GetComponent(aLink);
+		if (component != INDEX_NONE && GetLinkFreeVolume(aLink) > 0)
+		{
+			myData.myComponentOffsets[component + 1]++;
+		}
+	});
+
+	for (int32 i = 0; i < myData.myNumComponents; i++)
+	{
+		myData.myComponentOffsets[i + 1] += myData.myComponentOffsets[i];
+	}
+
+	const int32 numLinks = myData.myComponentOffsets.Last();
+	myData.myComponentLinks.SetNumUninitialized(numLinks);
+	myData.myComponentFreeVolumes.SetNumUninitialized(numLinks);
+
+	TArray<int32> cursors(myData.myComponentOffsets.GetData(), myData.myNumComponents);
+
+	ForEachNavLink([&](const SVONLink& aLink)
+	{
+		const int32 component = GetComponent(aLink);
+		const uint64 volume = component != INDEX_NONE ? GetLinkFreeVolume(aLink) : 0;
+		if (volume > 0)
+		{
+			const int32 index = cursors[component]++;
+			myData.myComponentLinks[index] = aLink;
+			myData.myComponentFreeVolumes[index] = volume;
+		}
+	});
+
+	for (int32 c = 0; c < myData.myNumComponents; c++)
+	{
+		for (int32 i = myData.myComponentOffsets[c] + 1; i < myData.myComponentOffsets[c + 1]; i++)
+		{
+			myData.myComponentFreeVolumes[i] += myData.myComponentFreeVolumes[i - 1];
+		}
+	}
+}
+
+struct SVONLandmarkEntry
+{
+	int32 myIndex;
+	float myDistance;
+};
+
+void ASVONVolume::BuildLandmarks()
+{
+	myData.myLandmarks.Reset();
+	myData.myLandmarkDistances.Reset();
+
+	if (myNumLandmarks <= 0 || myData.myNumNavIndices == 0)
+	{
+		return;
+	}
+
+	const int32 numIndices = myData.myNumNavIndices;
+
+	// Gather every nav link, and make the neighbour graph symmetric. Distances on the symmetric graph are never longer than
+	// the ones the pathfinder sees, so the triangle inequality bound stays admissible
+	TArray<SVONLink> links;
+	TArray<FVector> positions;
+	links.SetNum(numIndices);
+	positions.SetNum(numIndices);
+
+	// Every edge as a pair of nav indices, flattened
+	TArray<int32> edges;
+
+	TArray<SVONLink> neighbours;
+	ForEachNavLink([&](const SVONLink& aLink)
+	{
+		const int32 index = GetNavIndex(aLink);
+		links[index] = aLink;
+		GetLinkPosition(aLink, positions[index]);
+
+		neighbours.Reset();
+		GetNavNeighbours(aLink, neighbours);
+		for (const SVONLink& neighbour : neighbours)
+		{
+			const int32 neighbourIndex = GetNavIndex(neighbour);
+			if (neighbourIndex == INDEX_NONE)
+				continue;
+
+			edges.Add(index);
+			edges.Add(neighbourIndex);
+		}
+	});
+
+	// Both directions of every edge, packed per nav index (CSR), so each Dijkstra run walks flat arrays.
+	// An edge both ends listed shows up twice, which only costs a relaxation that fails
+	TArray<int32> adjacencyOffsets;
+	adjacencyOffsets.Init(0, numIndices + 1);
+	for (int32 i = 0; i < edges.Num(); i += 2)
+	{
+		adjacencyOffsets[edges[i] + 1]++;
+		adjacencyOffsets[edges[i + 1] + 1]++;
+	}
+	for (int32 i = 0; i < numIndices; i++)
+	{
+		adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+	}
+
+	TArray<int32> adjacency;
+	adjacency.SetNumUninitialized(adjacencyOffsets[numIndices]);
+
+	TArray<int32> cursors(adjacencyOffsets.GetData(), numIndices);
+	for (int32 i = 0; i < edges.Num(); i += 2)
+	{
+		adjacency[cursors[edges[i]]++] = edges[i + 1];
+		adjacency[cursors[edges[i + 1]]++] = edges[i];
+	}
+
+	edges.Empty();
+	cursors.Empty();
+
+	auto heapPredicate = [](const SVONLandmarkEntry& A, const SVONLandmarkEntry& B)
+	{
+		return A.myDistance < B.myDistance;
+	};
+
+	auto dijkstra = [&](int32 aSource, TArray<float>& oDistances)
+	{
+		oDistances.Init(FLT_MAX, numIndices);
+		oDistances[aSource] = 0.f;
+
+		TArray<SVONLandmarkEntry> open;
+		open.HeapPush({ aSource, 0.f }, heapPredicate);
+
+		while (open.Num() > 0)
+		{
+			SVONLandmarkEntry current;
+			open.HeapPop(current, heapPredicate);
+
+			if (current.myDistance > oDistances[current.myIndex])
+				continue;
+
+			for (int32 edge = adjacencyOffsets[current.myIndex]; edge < adjacencyOffsets[current.myIndex + 1]; edge++)
+			{
+				const int32 neighbour = adjacency[edge];
+				const float distance = current.myDistance + (positions[current.myIndex] - positions[neighbour]).Size();
+				if (distance < oDistances[neighbour])
+				{
+					oDistances[neighbour] = distance;
+					open.HeapPush({ neighbour, distance }, heapPredicate);
+				}
+			}
+		}
+	};
+
+	// Farthest point selection. Seed from any nav link, the first landmark is whatever is farthest from it,
+	// and each next landmark is the link farthest from all the landmarks we have so far
+	int32 seed = INDEX_NONE;
+	for (int32 i = 0; i < numIndices && seed == INDEX_NONE; i++)
+	{
+		if (myData.myComponents[i] != INDEX_NONE)
+		{
+			seed = i;
+		}
+	}
+
+	if (seed == INDEX_NONE)
+	{
+		return;
+	}
+
+	TArray<float> minDistances;
+	dijkstra(seed, minDistances);
+
+	for (int32 landmark = 0; landmark < myNumLandmarks; landmark++)
+	{
+		int32 farthest = INDEX_NONE;
+		float farthestDistance = 0.f;
+		for (int32 i = 0; i < numIndices; i++)
+		{
+			if (minDistances[i] != FLT_MAX && minDistances[i] > farthestDistance)
+			{
+				farthest = i;
+				farthestDistance = minDistances[i];
+			}
+		}
+
+		// Everything reachable is already a landmark
+		if (farthest == INDEX_NONE)
+		{
+			break;
+		}
+
+		myData.myLandmarkDistances.AddDefaulted();
+		TArray<float>& distances = myData.myLandmarkDistances.Last();
+		dijkstra(farthest, distances);
+		myData.myLandmarks.Add(links[farthest]);
+
+		for (int32 i = 0; i < numIndices; i++)
+		{
+			if (landmark == 0 || distances[i] < minDistances[i])
+			{
+				minDistances[i] = distances[i];
+			}
+		}
+	}
+
+	UE_LOG(UESVON, Display, TEXT("Landmarks : %d"), myData.myLandmarks.Num());
+}
+
+float ASVONVolume::GetVoxelSize(layerindex_t aLayer) const
+{
+	return myVoxelSizes[aLayer];
+}
+
+void ASVONVolume::CacheTransform()
+{
+	myZOrigin = myOrigin - myExtent;
+
+	myVoxelSizes.SetNum(myVoxelPower + 1);
+	for (int32 i = 0; i < myVoxelSizes.Num(); i++)
+	{
+		myVoxelSizes[i] = (myExtent.X / FMath::Pow(2, myVoxelPower)) * (FMath::Pow(2.0f, i + 1));
+	}
+
+	const float leafVoxelSize = myVoxelSizes[0] * 0.25f;
+	myInvLeafVoxelSize = leafVoxelSize > 0.f ? 1.f / leafVoxelSize : 0.f;
+}
+
+
+bool ASVONVolume::IsReadyForNavigation()
+{
+	return myIsReadyForNavigation;
+}
+
+
+bool ASVONVolume::IsReadyForFinishDestroy()
+{
+	return Super::IsReadyForFinishDestroy() && myNumPendingQueries.GetValue() == 0;
+}
+
+int32 ASVONVolume::GetNodesInLayer(layerindex_t aLayer)
+{
+	return FMath::Pow(FMath::Pow(2, (myVoxelPower - (aLayer))), 3);
+}
+
+int32 ASVONVolume::GetNodesPerSide(layerindex_t aLayer) const
+{
+	return FMath::Pow(2, (myVoxelPower - (aLayer)));
+}
+
+void ASVONVolume::BeginPlay()
+{
+	if (!myIsReadyForNavigation)
+	{
+		Generate();
+		myIsReadyForNavigation = true;
+	}
+}
+
+void ASVONVolume::PostRegisterAllComponents()
+{
+	Super::PostRegisterAllComponents();
+
+	if (GetWorld())
+	{
+		SVONNavigationManager::Get(GetWorld()).RegisterVolume(*this);
+	}
+}
+
+void ASVONVolume::PostUnregisterAllComponents()
+{
+	if (GetWorld())
+	{
+		SVONNavigationManager::Get(GetWorld()).UnregisterVolume(*this);
+	}
+
+	Super::PostUnregisterAllComponents();
+}
+
+void ASVONVolume::BuildNeighbourLinks(layerindex_t aLayer)
+{
+
+	TArray<SVONNode>& layer = GetLayer(aLayer);
+	layerindex_t searchLayer = aLayer;
+
+	// For each node
+	for (nodeindex_t i = 0; i < layer.Num(); i++)
+	{
+		SVONNode& node = layer[i];
+		// Get our world co-ordinate
+		uint_fast32_t x, y, z;
+		morton3D_64_decode(node.myCode, x, y, z);
+		nodeindex_t backtrackIndex = -1;
+		nodeindex_t index = i;
+		FVector nodePos;
+		GetNodePosition(aLayer, node.myCode, nodePos);
+
+		// For each direction
+		for (int d = 0; d < 6; d++)
+		{
+			SVONLink& linkToUpdate = node.myNeighbours[d];
+
+			backtrackIndex = index;
+
+			while (!FindLinkInDirection(searchLayer, index, d, linkToUpdate, nodePos)
+				&& aLayer < myData.myLayers.Num() - 2)
+			{
+				SVONLink& parent = GetLayer(searchLayer)[index].myParent;
+				if (parent.IsValid())
+				{
+					index = parent.myNodeIndex;
+					searchLayer = parent.myLayerIndex;
+				}
+				else
+				{
+					searchLayer++;
+					GetIndexForCode(searchLayer, node.myCode >> 3, index);
+				}
+
+			}
+			index = backtrackIndex;
+			searchLayer = aLayer;
+		}
+	}
+}
+
+bool ASVONVolume::FindLinkInDirection(layerindex_t aLayer, const nodeindex_t aNodeIndex, uint8 aDir, SVONLink& oLinkToUpdate, FVector& aStartPosForDebug)
+{
+	int32 maxCoord = GetNodesPerSide(aLayer);
+	SVONNode& node = GetLayer(aLayer)[aNodeIndex];
+	TArray<SVONNode>& layer = GetLayer(aLayer);
+
+	// Get our world co-ordinate
+	uint_fast32_t x = 0, y = 0, z = 0;
+	morton3D_64_decode(node.myCode, x, y, z);
+	int32 sX = x, sY = y, sZ = z;
+	// Add the direction
+	sX += SVONStatics::dirs[aDir].X;
+	sY += SVONStatics::dirs[aDir].Y;
+	sZ += SVONStatics::dirs[aDir].Z;
+
+	// If the coords are out of bounds, the link is invalid.
+	if (sX < 0 || sX >= maxCoord || sY < 0 || sY >= maxCoord || sZ < 0 || sZ >= maxCoord)
+	{
+		oLinkToUpdate.SetInvalid();
+		if (myShowNeighbourLinks)
+		{
+			FVector startPos, endPos;
+			GetNodePosition(aLayer, node.myCode, startPos);
+			endPos = startPos + (FVector(SVONStatics::dirs[aDir]) * 100.f);
+			DrawDebugLine(GetWorld(), aStartPosForDebug, endPos, FColor::Red, true, -1.f, 0, .0f);
+		}
+		return true;
+	}
+	x = sX; y = sY; z = sZ;
+	// Get the morton code for the direction
+	mortoncode_t thisCode = morton3D_64_encode(x, y, z);
+	bool isHigher = thisCode > node.myCode;
+	int32 nodeDelta = (isHigher ?  1 : - 1);
+
+	while ((aNodeIndex + nodeDelta) < layer.Num() && aNodeIndex + nodeDelta >= 0)
+	{
+		// This is the node we're looking for
+		if (layer[aNodeIndex + nodeDelta].myCode == thisCode)
+		{
+			const SVONNode& thisNode = layer[aNodeIndex + nodeDelta];
+			// This is a leaf node
+			if (aLayer == 0 && thisNode.HasChildren())
+			{
+				// Set invalid link if the leaf node is completely blocked, no point linking to it
+				if (GetLeafNode(thisNode.myFirstChild.GetNodeIndex()).IsCompletelyBlocked())
+				{
+					oLinkToUpdate.SetInvalid();
+					return true;
+				}
+			}
+			// Otherwise, use this link
+			oLinkToUpdate.myLayerIndex = aLayer;
+			check(aNodeIndex + nodeDelta < layer.Num());
+			oLinkToUpdate.myNodeIndex = aNodeIndex + nodeDelta;
+			if (myShowNeighbourLinks)
+			{
+				FVector endPos;
+				GetNodePosition(aLayer, thisCode, endPos);
+				DrawDebugLine(GetWorld(), aStartPosForDebug, endPos, SVONStatics::myLinkColors[aLayer], true, -1.f, 0, .0f);
+			}
+			return true;
+		}
+		// If we've passed the code we're looking for, it's not on this layer
+		else if ((isHigher && layer[aNodeIndex + nodeDelta].myCode > thisCode) || (!isHigher && layer[aNodeIndex + nodeDelta].myCode < thisCode))
+		{
+			return false;
+		}
+
+		nodeDelta += (isHigher ? 1 : -1);
+	}
+
+
+
+	// I'm not entirely sure if it's valid to reach the end? Hmmm...
+	return false;
+
+}
+
+void ASVONVolume::RasterizeLeafNode(FVector& aOrigin, nodeindex_t aLeafIndex)
+{
+	for (int i = 0; i < 64; i++)
+	{
+
+		uint_fast32_t x, y, z;
+		morton3D_64_decode(i, x, y, z);
+		float leafVoxelSize = GetVoxelSize(0) * 0.25f;
+		FVector position = aOrigin + FVector(x * leafVoxelSize, y * leafVoxelSize, z * leafVoxelSize) + FVector(leafVoxelSize * 0.5f);
+
+		if (aLeafIndex >= myData.myLeafNodes.Num() - 1)
+			myData.myLeafNodes.AddDefaulted(1);
 
 		if(IsBlocked(position, leafVoxelSize * 0.5f))
 		{
@@ -587,7 +1785,46 @@ TArray<SVONNode>& ASVONVolume::GetLayer(layerindex_t aLayer)
 
 const TArray<SVONNode>& ASVONVolume::GetLayer(layerindex_t aLayer) const
 {
-	return myData.myLayers[aLayer];
+	// Still generating, so the layers are there to read
+	if (myData.myLayers.IsValidIndex(aLayer))
+		return myData.myLayers[aLayer];
+
+	FScopeLock lock(&myUnpackedLayersLock);
+
+	// Sized once, so references handed out to other layers stay valid
+	if (myUnpackedLayers.Num() < myNumLayers)
+	{
+		myUnpackedLayers.SetNum(myNumLayers);
+	}
+
+	TArray<SVONNode>& layer = myUnpackedLayers[aLayer];
+	const int32 numNodes = myNumLayers > 0 && (myData.myNodeArena.IsBuilt() || myData.myLinearOctree.IsBuilt()) ? GetNumNodes(aLayer) : 0;
+	if (layer.Num() != numNodes)
+	{
+		layer.SetNum(numNodes);
+		for (int32 i = 0; i < numNodes; i++)
+		{
+			SVONNode& node = layer[i];
+			node.myCode = GetNodeCode(aLayer, i);
+			node.myParent = GetNodeParent(aLayer, i);
+			node.myFirstChild = GetNodeFirstChild(aLayer, i);
+
+			const SVONLink* neighbours = GetNodeNeighbours(aLayer, i);
+			for (int32 d = 0; d < 6; d++)
+			{
+				node.myNeighbours[d] = neighbours[d];
+			}
+		}
+	}
+
+	return layer;
+}
+
+const SVONNode& ASVONVolume::GetNode(const SVONLink& aLink) const
+{
+PRAGMA_DISABLE_DEPRECATION_WARNINGS
+	return GetLayer(aLink.GetLayerIndex())[aLink.GetNodeIndex()];
+PRAGMA_ENABLE_DEPRECATION_WARNINGS
 }
 
 // Check for blocking...using this cached set for each layer for now for fast lookups
@@ -23,10 +23,17 @@ class UESVON_API ASVONAIController : public AAIController
 
 	FNavPathSharedPtr myNavPath;
 
+	/* Find paths in the background, accepting the move straight away and following the path once it arrives */
+	UPROPERTY(EditAnywhere, Category = SVON)
+	bool myUseAsyncPathfinding = true;
+
 	/** Component used for moving along a path. */
 	UPROPERTY(VisibleDefaultsOnly, Category = SVON)
 	USVONNavigationComponent* SVONNavComponent;
 
 	FPathFollowingRequestResult MoveTo(const FAIMoveRequest& MoveRequest, FNavPathSharedPtr* OutPath = nullptr) override;
+
+	/* Hands an async result to the path following component, if it's for the move we're still making */
+	void OnAsyncPathResult(const SVONPathQueryResult& aResult, FNavPathSharedPtr aPath, FAIRequestID aRequestID);
 	
 };
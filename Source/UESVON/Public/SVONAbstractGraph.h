@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SVONLink.h"
+#include "SVONDefines.h"
+
+class ASVONVolume;
+
+struct SVONAbstractEdge
+{
+	int32 myTarget;
+	float myCost;
+	// Index into the cached intra-cluster paths, INDEX_NONE for an edge that crosses between clusters
+	int32 myPathIndex;
+};
+
+/* An entrance: a link on the face of a cluster, with a neighbour in the adjacent cluster */
+struct SVONAbstractNode
+{
+	SVONLink myLink;
+	FVector myPosition;
+	int32 myCluster;
+	TArray<SVONAbstractEdge> myEdges;
+};
+
+/*
+ * HPA* style abstraction of the octree. The nodes on a chosen layer are clusters (coarser free nodes are their own cluster),
+ * with an entrance on each face shared by two clusters and precomputed paths between the entrances of each cluster.
+ * A long query becomes a search from the start to its cluster's entrances, a search of the small abstract graph,
+ * and a search from the goal to its cluster's entrances.
+ */
+class UESVON_API SVONAbstractGraph
+{
+public:
+	void Build(const ASVONVolume& aVolume, layerindex_t aClusterLayer);
+	void Reset();
+
+	bool IsBuilt() const { return myNodes.Num() > 0; }
+	int32 GetNumNodes() const { return myNodes.Num(); }
+	int32 GetNumClusters() const { return myClusterEntrances.Num(); }
+
+	/* Finds a path from start to goal through the abstract graph. Returns false if both are in the same cluster, or there's no path */
+	bool FindPath(const ASVONVolume& aVolume, const SVONLink& aStart, const SVONLink& aGoal, TArray<SVONLink>& oLinks) const;
+
+private:
+	layerindex_t myClusterLayer = 0;
+
+	TArray<SVONAbstractNode> myNodes;
+
+	// Entrance node indices for each cluster, and the cluster index for each cluster key
+	TArray<TArray<int32>> myClusterEntrances;
+	TMap<uint64, int32> myClusterIndices;
+
+	// Cached link paths between entrances of the same cluster
+	TArray<TArray<SVONLink>> myIntraPaths;
+
+	uint64 GetClusterKey(const ASVONVolume& aVolume, const SVONLink& aLink) const;
+
+	/* Dijkstra from aFrom, never leaving aClusterKey, until every target is reached */
+	void SearchCluster(const ASVONVolume& aVolume, const SVONLink& aFrom, uint64 aClusterKey, const TSet<SVONLink>& aTargets, TMap<SVONLink, float>& oCosts, TMap<SVONLink, SVONLink>& oCameFrom) const;
+
+	static void WalkBack(const TMap<SVONLink, SVONLink>& aCameFrom, SVONLink aLink, TArray<SVONLink>& oLinks);
+};
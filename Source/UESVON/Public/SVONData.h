@@ -3,10 +3,44 @@
 #include "CoreMinimal.h"
 #include "SVONNode.h"
 #include "SVONLeafNode.h"
+#include "SVONAbstractGraph.h"
+#include "SVONNodeArena.h"
+#include "SVONLinearOctree.h"
 
 struct SVONData
 {
-	// SVO data
+	// SVO data. The layers are only kept while generating, then packed into one of the layouts below and freed
 	TArray<TArray<SVONNode>> myLayers;
 	TArray<SVONLeafNode> myLeafNodes;
+
+	// The layers packed into one allocation, read by everything once generation is done
+	SVONNodeArena myNodeArena;
+	// Or, if the volume asks for it, the pointerless layout in its place
+	SVONLinearOctree myLinearOctree;
+
+	// Flat index space over every navigable link: each layer's nodes, then 64 subnodes per leaf node
+	TArray<int32> myLayerNavOffsets;
+	int32 myLeafNavOffset = 0;
+	int32 myNumNavIndices = 0;
+
+	// Connected free-space component for each flat nav index, INDEX_NONE for blocked subnodes
+	TArray<int32> myComponents;
+	int32 myNumComponents = 0;
+
+	// Running total of free volume (in leaf voxels) over each layer's nodes, for volume weighted random sampling
+	TArray<TArray<uint64>> myLayerFreeVolumes;
+	// The sum of the layers' totals
+	uint64 myTotalFreeVolume = 0;
+
+	// Free links grouped by component (the range for component c starts at myComponentOffsets[c]), with a running free volume total within each component
+	TArray<SVONLink> myComponentLinks;
+	TArray<uint64> myComponentFreeVolumes;
+	TArray<int32> myComponentOffsets;
+
+	// ALT landmark links, and the shortest path distance from each landmark to every flat nav index (FLT_MAX if unreachable)
+	TArray<SVONLink> myLandmarks;
+	TArray<TArray<float>> myLandmarkDistances;
+
+	// Optional HPA* abstraction, built if the volume asks for it
+	SVONAbstractGraph myAbstractGraph;
 };
\ No newline at end of file
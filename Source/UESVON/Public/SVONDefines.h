@@ -15,6 +15,17 @@ enum class EBuildTrigger : uint8
 	Manual 	UMETA(DisplayName = "Manual")
 };
 
+UENUM(BlueprintType)
+enum class ESVONPathCostType : uint8
+{
+	// Straight line distance between node centres
+	Euclidean	UMETA(DisplayName = "Euclidean"),
+	// The same cost for every step between nodes, so big nodes are cheap to cross
+	UnitCost	UMETA(DisplayName = "Unit Cost"),
+	// Distance scaled down by the size of the node being entered
+	SizeScaled	UMETA(DisplayName = "Size Scaled")
+};
+
 enum class dir : uint8
 {
 	pX, nX, pY, nY, pZ, nZ
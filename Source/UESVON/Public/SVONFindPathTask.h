@@ -1,41 +1,105 @@
 #pragma once
 
 #include "Runtime/Core/Public/Async/AsyncWork.h"
+#include "Async/Async.h"
+#include "SVONPathQuery.h"
 
 class FSVONFindPathTask : public FNonAbandonableTask
 {
 	friend class FAutoDeleteAsyncTask<FSVONFindPathTask>;
 
 public:
-	FSVONFindPathTask(ASVONVolume& aVolume, UWorld* aWorld, const SVONLink aStart, const SVONLink aTarget, FNavPathSharedPtr* oPath, TQueue<int>& aQueue, TArray<FVector>& aDebugOpenPoints) :
+	FSVONFindPathTask(ASVONVolume& aVolume, const SVONPathQueryStatePtr& aState) :
 		myVolume(aVolume),
-		myWorld(aWorld),
-		myStart(aStart),
-		myTarget(aTarget),
-		myPath(oPath),
-		myOutQueue(aQueue),
-		myDebugOpenPoints(aDebugOpenPoints)
-	{}
+		myState(aState)
+	{
+		// Keeps the volume (and its octree) alive until the search is done with it
+		myVolume.BeginPathQuery();
+	}
 
 protected:
 	ASVONVolume& myVolume;
-	UWorld* myWorld;
-
-	SVONLink myStart;
-	SVONLink myTarget;
-	FNavPathSharedPtr* myPath;
 
-	TQueue<int>& myOutQueue;
-	TArray<FVector>& myDebugOpenPoints;
+	SVONPathQueryStatePtr myState;
 
 	void DoWork()
 	{
-		SVONPathFinder pathFinder(myVolume, true, myWorld, myDebugOpenPoints);
+		if (!myState->myIsCancelled)
+		{
+			Search();
+		}
+
+		myVolume.EndPathQuery();
+
+		// Hand the result back on the game thread. The state travels with the lambda, so nothing here refers back to the requester
+		SVONPathQueryStatePtr state = myState;
+		AsyncTask(ENamedThreads::GameThread, [state]()
+		{
+			state->myIsComplete = true;
+			if (!state->myIsCancelled)
+			{
+				state->myOnComplete.ExecuteIfBound(state->myResult);
+			}
+		});
+	}
+
+	void Search()
+	{
+		const SVONPathFinderSettings& settings = myState->mySettings;
+
+		myState->myResult.myDebugPoints.Reset();
+
+		SVONPathFinder pathFinder(myVolume, myState->myDebugOpenNodes, nullptr, myState->myResult.myDebugPoints, settings);
+
+		// A quick bounded search first, so the requester has somewhere to go while the full search runs
+		const int32 partialIterations = myState->myPartialIterations;
+		const bool isEarlyPass = partialIterations > 0 && (settings.myMaxIterations <= 0 || partialIterations < settings.myMaxIterations);
+		if (isEarlyPass)
+		{
+			pathFinder.SetSearchLimits(partialIterations, settings.myMaxMilliseconds);
+		}
 
-		int result = pathFinder.FindPath(myStart, myTarget, myPath);
+		const double startTime = FPlatformTime::Seconds();
 
-		myOutQueue.Enqueue(result);
-		
+		myState->myResult.myResult = pathFinder.FindPath(myState->myStart, myState->myTarget, nullptr);
+		StoreResult(pathFinder);
+
+		if (!isEarlyPass || pathFinder.GetStatus() != ESVONPathStatus::Partial)
+			return;
+
+		// The early pass already spent the query's own time limit, so its partial path is the answer
+		const float elapsedMs = (FPlatformTime::Seconds() - startTime) * 1000.0;
+		if (settings.myMaxMilliseconds > 0.f && elapsedMs >= settings.myMaxMilliseconds)
+			return;
+
+		SVONPathQueryStatePtr state = myState;
+		SVONPathQueryResult partialResult = myState->myResult;
+		partialResult.myIsPartial = true;
+
+		AsyncTask(ENamedThreads::GameThread, [state, partialResult]()
+		{
+			if (!state->myIsCancelled && !state->myIsComplete)
+			{
+				state->myOnComplete.ExecuteIfBound(partialResult);
+			}
+		});
+
+		if (myState->myIsCancelled)
+			return;
+
+		// Carry on from the open and closed sets the early pass stopped with, under what's left of the query's limits
+		pathFinder.SetSearchLimits(
+			settings.myMaxIterations > 0 ? settings.myMaxIterations - pathFinder.GetNumIterations() : 0,
+			settings.myMaxMilliseconds > 0.f ? settings.myMaxMilliseconds - elapsedMs : 0.f);
+
+		myState->myResult.myResult = pathFinder.ResumePath(nullptr);
+		StoreResult(pathFinder);
+	}
+
+	void StoreResult(const SVONPathFinder& aPathFinder)
+	{
+		myState->myResult.myStatus = aPathFinder.GetStatus();
+		myState->myResult.myPath = aPathFinder.GetPath();
 	}
 
 	// This next section of code needs to be here.  Not important as to why.
@@ -44,4 +108,4 @@ protected:
 	{
 		RETURN_QUICK_DECLARE_CYCLE_STAT(FSVONFindPathTask, STATGROUP_ThreadPoolAsyncTasks);
 	}
-};
\ No newline at end of file
+};
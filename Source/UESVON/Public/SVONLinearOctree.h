@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SVONLink.h"
+#include "SVONDefines.h"
+
+struct SVONNode;
+
+/*
+ * Pointerless layout of the octree's layers. Each layer is stored as one "has children" bit per node, plus neighbour links.
+ * Layers only hold complete groups of 8 siblings in morton order, so the first child of a node is 8 times the number of
+ * nodes with children before it (a rank), its parent is found by the inverse (a select), and codes follow from the parent chain
+ */
+class UESVON_API SVONLinearOctree
+{
+public:
+	/* Builds from the generated layers. Returns false, leaving this empty, if a layer doesn't have the implicit structure */
+	bool Build(const TArray<TArray<SVONNode>>& aLayers);
+	void Reset();
+
+	bool IsBuilt() const { return myLayers.Num() > 0; }
+
+	int32 GetNumNodes(layerindex_t aLayer) const { return myLayers[aLayer].myNumNodes; }
+
+	FORCEINLINE bool HasChildren(layerindex_t aLayer, nodeindex_t aIndex) const
+	{
+		return (myLayers[aLayer].myChildBits[aIndex >> 6] & (1ull << (aIndex & 63))) != 0;
+	}
+
+	/* Layer 0 children are the leaf node with the same index */
+	FORCEINLINE SVONLink GetFirstChild(layerindex_t aLayer, nodeindex_t aIndex) const
+	{
+		if (!HasChildren(aLayer, aIndex))
+			return SVONLink::GetInvalidLink();
+
+		return aLayer == 0 ? SVONLink(0, aIndex, 0) : SVONLink(aLayer - 1, Rank(aLayer, aIndex) * 8, 0);
+	}
+
+	SVONLink GetParent(layerindex_t aLayer, nodeindex_t aIndex) const;
+
+	/* The first of the 8 siblings this node is one of */
+	FORCEINLINE nodeindex_t GetFirstSibling(nodeindex_t aIndex) const { return aIndex & ~7; }
+
+	/* Walks up the parent chain with a select per layer, so it's O(layers * log n). Avoid it in hot loops, GetIndexForCode is cheaper */
+	mortoncode_t GetCode(layerindex_t aLayer, nodeindex_t aIndex) const;
+
+	/* Binary searches the top codes, then descends by child indices with a rank per layer */
+	bool GetIndexForCode(layerindex_t aLayer, mortoncode_t aCode, nodeindex_t& oIndex) const;
+
+	/* A node's 6 neighbour links, in SVONStatics::dirs order */
+	FORCEINLINE const SVONLink* GetNeighbours(layerindex_t aLayer, nodeindex_t aIndex) const { return myLayers[aLayer].myNeighbours.GetData() + aIndex * 6; }
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	struct SVONLinearLayer
+	{
+		int32 myNumNodes = 0;
+		// One bit per node, set if it has children
+		TArray<uint64> myChildBits;
+		// Number of set bits before each word of myChildBits
+		TArray<uint32> myRanks;
+		TArray<SVONLink> myNeighbours;
+	};
+
+	TArray<SVONLinearLayer> myLayers;
+	// The highest layer with nodes in it, whose nodes have no parents, so we keep their codes
+	layerindex_t myTopLayer = 0;
+	TArray<mortoncode_t> myTopCodes;
+
+	/* Number of nodes with children before aIndex */
+	FORCEINLINE int32 Rank(layerindex_t aLayer, nodeindex_t aIndex) const
+	{
+		const SVONLinearLayer& layer = myLayers[aLayer];
+		const uint64 below = layer.myChildBits[aIndex >> 6] & ((1ull << (aIndex & 63)) - 1);
+		return layer.myRanks[aIndex >> 6] + FMath::CountBits(below);
+	}
+
+	/* Index of the aRank'th node with children */
+	nodeindex_t Select(layerindex_t aLayer, int32 aRank) const;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "CoreMinimal.h"
+
 class ASVONVolume;
 struct SVONLink;
 
@@ -8,6 +10,27 @@ class UESVON_API SVONMediator
 public:
 	static bool GetLinkFromPosition(const FVector& aPosition, const ASVONVolume& aVolume, SVONLink& oLink);
 
+	/* 
+	 * Point location for something that moves a little each frame. Checks the node of aHint (usually last frame's link), 
+	 * then the 6 nodes next to it, and only does a full descent if the position is in none of them
+	 */
+	static bool GetLinkFromPositionCoherent(const FVector& aPosition, const ASVONVolume& aVolume, const SVONLink& aHint, SVONLink& oLink);
+
+	/* 
+	 * Locates a batch of positions at once, writing an invalid link for any that are outside the volume or blocked.
+	 * Quantization and morton encoding are vectorized, and the descents run in morton order so neighbouring queries share nodes
+	 */
+	static void GetLinksFromPositions(TArrayView<const FVector> aPositions, const ASVONVolume& aVolume, TArrayView<SVONLink> oLinks);
+
+	/* 
+	 * The closest free link to a position within aMaxRadius, and the closest point inside it. Searches spheres of growing radius
+	 * around the position, so free space that isn't connected to the position's own leaf is found too. A position already in free space is returned as is
+	 */
+	static bool GetNearestNavigableLink(const FVector& aPosition, const ASVONVolume& aVolume, float aMaxRadius, SVONLink& oLink, FVector& oPosition);
+
 	static void GetVolumeXYZ(const FVector& aPosition, const ASVONVolume& aVolume, const int aLayer, FIntVector& oXYZ);
 
+	/* Are both positions in the same connected region of free space? False if either isn't in navigable space */
+	static bool IsSameRegion(const FVector& aPositionA, const FVector& aPositionB, const ASVONVolume& aVolume);
+
 };
\ No newline at end of file
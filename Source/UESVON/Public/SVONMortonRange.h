@@ -0,0 +1,76 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SVONDefines.h"
+#include "libmorton/morton.h"
+
+/* An inclusive range of morton codes on a single layer of the octree */
+struct UESVON_API SVONMortonRange
+{
+	layerindex_t myLayer;
+	mortoncode_t myMin;
+	mortoncode_t myMax;
+
+	SVONMortonRange() :
+		myLayer(0),
+		myMin(0),
+		myMax(0) {}
+
+	SVONMortonRange(layerindex_t aLayer, mortoncode_t aMin, mortoncode_t aMax)
+		: myLayer(aLayer),
+		myMin(aMin),
+		myMax(aMax) {}
+
+	/* Does this range touch the node with the given code on the given layer? */
+	bool Overlaps(layerindex_t aLayer, mortoncode_t aCode) const
+	{
+		if (aLayer >= myLayer)
+		{
+			// The node covers a block of codes on our layer, test the two intervals
+			const uint32 shift = 3 * (aLayer - myLayer);
+			const mortoncode_t first = aCode << shift;
+			const mortoncode_t last = ((aCode + 1) << shift) - 1;
+			return first <= myMax && last >= myMin;
+		}
+
+		// The node is finer than our layer, so just test its ancestor
+		const mortoncode_t ancestor = aCode >> (3 * (myLayer - aLayer));
+		return ancestor >= myMin && ancestor <= myMax;
+	}
+
+	/* Is a code inside the box between two inclusive corners, on the same layer? */
+	static bool IsInBox(mortoncode_t aCode, const FIntVector& aMin, const FIntVector& aMax)
+	{
+		uint_fast32_t x = 0, y = 0, z = 0;
+		morton3D_64_decode(aCode, x, y, z);
+		return (int32)x >= aMin.X && (int32)x <= aMax.X && (int32)y >= aMin.Y && (int32)y <= aMax.Y && (int32)z >= aMin.Z && (int32)z <= aMax.Z;
+	}
+
+	/* Does a box cover every code between its corners' codes, with nothing outside it in between? */
+	static bool IsContiguous(const FIntVector& aMin, const FIntVector& aMax)
+	{
+		const mortoncode_t numCodes = morton3D_64_encode(aMax.X, aMax.Y, aMax.Z) - morton3D_64_encode(aMin.X, aMin.Y, aMin.Z) + 1;
+		const FIntVector size = aMax - aMin + FIntVector(1);
+		return numCodes == (mortoncode_t)size.X * size.Y * size.Z;
+	}
+
+	/*
+	 * Splits a box where the codes of its corners first differ, giving LITMAX (the max corner of the lower half) and BIGMIN (the min corner of the upper half).
+	 * Every code between the corners that's in the box is in [min, LITMAX] or [BIGMIN, max], and the codes between LITMAX and BIGMIN aren't in it at all
+	 */
+	static void SplitBox(const FIntVector& aMin, const FIntVector& aMax, FIntVector& oLitMax, FIntVector& oBigMin)
+	{
+		const mortoncode_t difference = morton3D_64_encode(aMin.X, aMin.Y, aMin.Z) ^ morton3D_64_encode(aMax.X, aMax.Y, aMax.Z);
+		const uint32 bit = FMath::FloorLog2_64(difference);
+		const int32 axis = bit % 3;
+		const int32 level = bit / 3;
+
+		// The max corner has this bit set and the min corner doesn't, everything above it is shared
+		const int32 split = (aMax[axis] >> level) << level;
+
+		oLitMax = aMax;
+		oLitMax[axis] = split - 1;
+		oBigMin = aMin;
+		oBigMin[axis] = split;
+	}
+};
@@ -6,10 +6,14 @@
 #include "Components/ActorComponent.h"
 #include "SVONPath.h"
 #include "SVONLink.h"
+#include "SVONPathScheduler.h"
+#include "SVONPathQuery.h"
+#include "SVONPathFinder.h"
 #include "SVONNavigationComponent.generated.h"
 
 class ASVONVolume;
 struct SVONLink;
+struct SVONMortonRange;
 
 
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
@@ -24,6 +28,57 @@ public:
 	bool DebugPrintMortonCodes;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation")
 	bool DebugDrawOpenNodes = false;
+	// Give up (and use the best partial path) after expanding this many nodes. 0 for no limit
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation")
+	int32 MaxSearchIterations = 0;
+	// Give up (and use the best partial path) after searching for this many milliseconds. 0 for no limit
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation")
+	float MaxSearchMilliseconds = 0.f;
+	// Async queries first run a search capped at this many iterations, and deliver its partial path early. 0 to disable
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation")
+	int32 PartialPathIterations = 0;
+	// Find a coarse corridor first, and only refine inside it. Much cheaper for long paths
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation")
+	bool UseHierarchicalSearch = false;
+	// The layer the coarse corridor is found on
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation", meta = (EditCondition = "UseHierarchicalSearch", ClampMin = "1", ClampMax = "12"))
+	int32 CorridorLayer = 3;
+	// Route queries between clusters through the volume's abstract graph, if it built one
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation")
+	bool UseAbstractGraph = false;
+	// Use the volume's landmark tables for a tighter, admissible heuristic, if it built them
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation")
+	bool UseLandmarkHeuristic = false;
+	// Search from both ends, which expands fewer nodes when both ends are in cluttered space
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation")
+	bool UseBidirectionalSearch = false;
+	// How steps between nodes are costed. Unit and size scaled costs favour big nodes, and expand far fewer of them
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation")
+	ESVONPathCostType PathCostType = ESVONPathCostType::Euclidean;
+	// Heuristic multiplier. Above 1 trades path optimality for fewer expansions
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation", meta = (ClampMin = "0"))
+	float HeuristicWeight = 1.f;
+	// Jump along straight runs of free leaf voxels instead of expanding each one
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation")
+	bool UseJumpPointSearch = false;
+	// Any-angle search, giving short straight paths with few points to follow
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation")
+	bool UseThetaStar = false;
+	// Targets in blocked space (say, picked on a surface) are moved to the nearest free point within this distance. 0 to disable
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation", meta = (ClampMin = "0"))
+	float TargetSnapRadius = 250.f;
+	// Skip path points we can see past, using the octree's line of sight
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation|Smoothing")
+	bool StringPullPath = false;
+	// Resample the path along a spline through its points
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation|Smoothing")
+	bool ResamplePath = false;
+	// Roughly how far apart resampled points are
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation|Smoothing", meta = (EditCondition = "ResamplePath", ClampMin = "1"))
+	float ResampleSpacing = 100.f;
+	// Drop points in the middle of straight runs
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SVO Navigation|Smoothing")
+	bool RemoveCollinearPoints = false;
 
 	// Sets default values for this component's properties
 	USVONNavigationComponent();
@@ -32,25 +87,35 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	// The current navigation volume
 	ASVONVolume* myCurrentNavVolume;
 
 	// Do I have a valid nav volume ready?
 	bool HasNavVolume();
 
-	// Check the scene for a valid volume that I am within the extents of
+	// Ask the world's navigation manager for a volume that I am within the extents of
 	bool FindVolume();
 
+	// Get the nav link for a path target, moving it out of blocked space if we can. oTargetPosition is where the path should end
+	bool GetTargetNavLink(const FVector& aTargetPosition, SVONLink& oLink, FVector& oTargetPosition) const;
+
 	// Print current layer/morton code information
 	void DebugLocalPosition(FVector& aPosition);
 
 	SVONLink myLastLocation;
 
-	TQueue<int> myJobQueue;
+	// Our in-flight async query, if any. A new request cancels the previous one
+	FSVONPathQueryHandle myPendingQuery;
+
 	TArray<FVector> myDebugPoints;
 
 	bool myIsBusy;
 
+	// The octree path behind the last nav path we generated, kept for revalidation
+	SVONPath myCurrentPath;
+
 	int myPointDebugIndex;
 
 public:	
@@ -60,9 +125,29 @@ public:
 	// Get a Nav position
 	SVONLink GetNavPosition(FVector& aPosition);
 
-	/* This method isn't hooked up at the moment, pending integration with existing systems */
-	bool FindPathAsync(const FVector& aStartPosition, const FVector& aTargetPosition, FNavPathSharedPtr* oNavPath);
+	/* Called by the navigation manager with the volume we're in and our batched nav position */
+	void SetCurrentNavVolume(ASVONVolume* aVolume);
+	void UpdateNavPosition(const FVector& aPosition, const SVONLink& aLink);
+
+	/* 
+	 * Starts a background path query. The result is delivered through aOnComplete on the game thread, 
+	 * unless the query is cancelled through the returned handle, by a later request, or by this component ending play
+	 */
+	FSVONPathQueryHandle FindPathAsync(const FVector& aStartPosition, const FVector& aTargetPosition, const FSVONPathQueryComplete& aOnComplete);
+
+	void CancelPendingQuery();
+
+	/* The search options for this agent's queries */
+	SVONPathFinderSettings GetPathFinderSettings() const;
 
 	bool FindPathImmediate(const FVector& aStartPosition, const FVector& aTargetPosition, FNavPathSharedPtr* oNavPath);
 
+	/* Queue a request on the world's path scheduler. The nav path is filled in and marked ready when the request is processed */
+	bool FindPathScheduled(const FVector& aStartPosition, const FVector& aTargetPosition, ESVONPathPriority aPriority, FNavPathSharedPtr aNavPath);
+
+	const SVONPath& GetCurrentPath() const { return myCurrentPath; }
+
+	/* Does a change to these regions of the octree invalidate our current path? If not, there's no need to replan */
+	bool IsCurrentPathInvalidatedBy(const TArray<SVONMortonRange>& aChangedRanges) const;
+
 };
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "SVONLink.h"
+
+class ASVONVolume;
+class USVONNavigationComponent;
+
+/*
+ * Per-world registry of nav volumes and navigation agents.
+ * Volumes are indexed in a coarse hash grid, so finding the volume around a point doesn't scan the world's actors.
+ * Agents don't look themselves up every tick, instead their nav positions are updated here, batched per volume
+ */
+class UESVON_API SVONNavigationManager : public FTickableGameObject
+{
+public:
+	SVONNavigationManager(UWorld* aWorld);
+	virtual ~SVONNavigationManager() {};
+
+	/* Get (or create) the manager for this world */
+	static SVONNavigationManager& Get(UWorld* aWorld);
+
+	/* Add a volume, or update its bounds if it's already registered */
+	void RegisterVolume(ASVONVolume& aVolume);
+	void UnregisterVolume(ASVONVolume& aVolume);
+
+	/* The registered volume containing this position, if any */
+	ASVONVolume* FindVolume(const FVector& aPosition) const;
+
+	void RegisterAgent(USVONNavigationComponent& aAgent);
+	void UnregisterAgent(USVONNavigationComponent& aAgent);
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return myAgents.Num() > 0; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return myWorld.Get(); }
+	//~ End FTickableGameObject Interface
+
+private:
+	struct SVONVolumeEntry
+	{
+		TWeakObjectPtr<ASVONVolume> myVolume;
+		FBox myBounds;
+		// Too big to put in the grid, checked against every lookup instead
+		bool myIsLarge;
+	};
+
+	/* Agents in one volume, gathered for a batched lookup */
+	struct SVONAgentBatch
+	{
+		TArray<USVONNavigationComponent*> myAgents;
+		TArray<FVector> myPositions;
+		TArray<SVONLink> myLinks;
+	};
+
+	TWeakObjectPtr<UWorld> myWorld;
+
+	TArray<SVONVolumeEntry> myVolumes;
+	TMap<FIntVector, TArray<int32>> myVolumeGrid;
+	TArray<int32> myLargeVolumes;
+
+	TArray<TWeakObjectPtr<USVONNavigationComponent>> myAgents;
+
+	// Kept between ticks to reuse their allocations. Weak keys, so a destroyed volume's batch can't be mistaken for a new one at its address
+	TMap<TWeakObjectPtr<ASVONVolume>, SVONAgentBatch> myBatches;
+
+	FIntVector GetGridCell(const FVector& aPosition) const;
+	void RebuildVolumeGrid();
+
+	static void OnWorldCleanup(UWorld* aWorld, bool aSessionEnded, bool aCleanupResources);
+	static TMap<TWeakObjectPtr<UWorld>, TSharedPtr<SVONNavigationManager>> ourManagers;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SVONLink.h"
+#include "SVONDefines.h"
+
+struct SVONNode;
+
+/*
+ * Structure of arrays layout of the octree's layers, packed into one allocation once they're built and used in their place.
+ * Searches and point location mostly read child links, neighbour links and codes, so each is its own array
+ * rather than sharing cache lines with the rest of the node. Nodes are addressed by layer and index, as in the layers
+ */
+class UESVON_API SVONNodeArena
+{
+public:
+	void Build(const TArray<TArray<SVONNode>>& aLayers);
+	void Reset();
+
+	bool IsBuilt() const { return myLayerOffsets.Num() > 0; }
+
+	int32 GetNumNodes(layerindex_t aLayer) const { return myLayerOffsets[aLayer + 1] - myLayerOffsets[aLayer]; }
+
+	/* A layer's codes, in (sorted) node order */
+	FORCEINLINE const mortoncode_t* GetCodes(layerindex_t aLayer) const { return GetArray<mortoncode_t>(myCodesOffset) + myLayerOffsets[aLayer]; }
+	FORCEINLINE mortoncode_t GetCode(layerindex_t aLayer, nodeindex_t aIndex) const { return GetCodes(aLayer)[aIndex]; }
+
+	FORCEINLINE const SVONLink& GetParent(layerindex_t aLayer, nodeindex_t aIndex) const { return GetArray<SVONLink>(myParentsOffset)[myLayerOffsets[aLayer] + aIndex]; }
+	FORCEINLINE const SVONLink& GetFirstChild(layerindex_t aLayer, nodeindex_t aIndex) const { return GetArray<SVONLink>(myFirstChildrenOffset)[myLayerOffsets[aLayer] + aIndex]; }
+
+	/* A node's 6 neighbour links, in SVONStatics::dirs order */
+	FORCEINLINE const SVONLink* GetNeighbours(layerindex_t aLayer, nodeindex_t aIndex) const { return GetArray<SVONLink>(myNeighboursOffset) + (myLayerOffsets[aLayer] + aIndex) * 6; }
+
+	SIZE_T GetAllocatedSize() const { return myBuffer.GetAllocatedSize() + myLayerOffsets.GetAllocatedSize(); }
+
+private:
+	// One allocation, with each array starting on its own cache line. Arrays are kept as offsets so the arena can be copied
+	TArray<uint8, TAlignedHeapAllocator<64>> myBuffer;
+
+	// Where each layer starts in the arrays, with the total node count on the end
+	TArray<int32> myLayerOffsets;
+
+	int32 myFirstChildrenOffset = 0;
+	int32 myNeighboursOffset = 0;
+	int32 myCodesOffset = 0;
+	int32 myParentsOffset = 0;
+
+	template<typename T>
+	FORCEINLINE const T* GetArray(int32 aOffset) const { return reinterpret_cast<const T*>(myBuffer.GetData() + aOffset); }
+};
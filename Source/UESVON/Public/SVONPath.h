@@ -1,13 +1,22 @@
 #pragma once
 #include "CoreMinimal.h"
+#include "SVONLink.h"
+#include "SVONDefines.h"
+
+struct SVONMortonRange;
 
 struct UESVON_API SVONPath
 {
 protected:
 	TArray<FVector> myPoints;
 
+	// The links traversed by the path, start to goal, with the morton code of each link's node
+	TArray<SVONLink> myLinks;
+	TArray<mortoncode_t> myLinkCodes;
+
 public:
 	void AddPoint(const FVector& aPoint);
+	void AddLink(const SVONLink& aLink, mortoncode_t aCode);
 	void ResetPath();
 
 	void DebugDraw(UWorld* aWorld);
@@ -15,4 +24,14 @@ public:
 	const TArray<FVector>& GetPoints() const {
 		return myPoints;
 	};
-};
\ No newline at end of file
+
+	const TArray<SVONLink>& GetLinks() const {
+		return myLinks;
+	};
+
+	/* Does any link on the path fall inside one of the changed ranges? Sorts the ranges, then binary searches them per link */
+	bool IsInvalidatedBy(const TArray<SVONMortonRange>& aChangedRanges) const;
+
+	/* Does any link on the path have its bit set in the per-layer changed node overlay? Linear in path length */
+	bool IsInvalidatedBy(const TArray<TBitArray<>>& aChangedNodes) const;
+};
@@ -1,30 +1,182 @@
 
 #pragma once
 #include "CoreMinimal.h"
+#include "SVONPath.h"
+#include "SVONLink.h"
+#include "SVONDefines.h"
 
 
-struct SVONPath;
 class ASVONVolume;
-struct SVONLink;
+struct SVONNode;
 
 struct FNavigationPath;
 
+enum class ESVONPathStatus : uint8
+{
+	// No path, the goal is unreachable from the start
+	Failed,
+	// Full path to the goal
+	Complete,
+	// A search limit was hit, the path leads to the expanded node closest to the goal
+	Partial
+};
+
+/* Per-query search options */
+struct UESVON_API SVONPathFinderSettings
+{
+	// Stop after expanding this many nodes. 0 for no limit
+	int32 myMaxIterations = 0;
+	// Stop after searching for this long. 0 for no limit
+	float myMaxMilliseconds = 0.f;
+
+	// Find a corridor on a coarse layer first, then only search the octree inside it
+	bool myUseHierarchicalSearch = false;
+	// The layer the corridor is found on. Higher is cheaper, but the corridor is less accurate
+	layerindex_t myCorridorLayer = 3;
+	// How many coarse cells to widen the corridor by, on each side
+	int32 myCorridorPadding = 1;
+	// Cost multiplier for coarse cells that contain some blocking
+	float myPartiallyBlockedPenalty = 4.f;
+
+	// Use the volume's abstract cluster graph for queries between clusters, if it has one
+	bool myUseAbstractGraph = false;
+
+	// Use the volume's landmark distance tables for an admissible ALT heuristic, if it has them. Unidirectional search only
+	bool myUseLandmarkHeuristic = false;
+
+	// Search from both ends at once, stopping when the frontiers meet. Only steps between free links, whose neighbours are symmetric
+	bool myUseBidirectionalSearch = false;
+
+	// How moving between two links is costed. Anything but Euclidean favours big nodes, and paths are no longer shortest
+	ESVONPathCostType myPathCostType = ESVONPathCostType::Euclidean;
+	// Multiplier on the heuristic. Above 1 expands fewer nodes, at the cost of optimality
+	float myHeuristicWeight = 1.f;
+
+	// Expand leaf subnodes with 3D jump point search, skipping straight runs of free voxels. Unidirectional search only
+	bool myUseJumpPointSearch = false;
+
+	// Theta* any-angle search. A link's parent can be any ancestor it has octree line of sight to, which gives short paths with few points
+	bool myUseThetaStar = false;
+
+	// Path post-processing, run in this order on the built path
+	// Greedily skip any point the previous kept point has octree line of sight past
+	bool myStringPullPath = false;
+	// Resample along a Catmull-Rom spline through the points, about this far apart. Segments where the curve would clip geometry stay straight
+	bool myResamplePath = false;
+	float myResampleSpacing = 100.f;
+	// Drop points that lie on a straight line between their neighbours
+	bool myRemoveCollinearPoints = false;
+
+	bool operator==(const SVONPathFinderSettings& aOther) const
+	{
+		return myMaxIterations == aOther.myMaxIterations && myMaxMilliseconds == aOther.myMaxMilliseconds
+			&& myUseHierarchicalSearch == aOther.myUseHierarchicalSearch && myCorridorLayer == aOther.myCorridorLayer
+			&& myCorridorPadding == aOther.myCorridorPadding && myPartiallyBlockedPenalty == aOther.myPartiallyBlockedPenalty
+			&& myUseAbstractGraph == aOther.myUseAbstractGraph && myUseLandmarkHeuristic == aOther.myUseLandmarkHeuristic
+			&& myUseBidirectionalSearch == aOther.myUseBidirectionalSearch && myPathCostType == aOther.myPathCostType
+			&& myHeuristicWeight == aOther.myHeuristicWeight && myUseJumpPointSearch == aOther.myUseJumpPointSearch
+			&& myUseThetaStar == aOther.myUseThetaStar && myStringPullPath == aOther.myStringPullPath
+			&& myResamplePath == aOther.myResamplePath && myResampleSpacing == aOther.myResampleSpacing
+			&& myRemoveCollinearPoints == aOther.myRemoveCollinearPoints;
+	}
+
+	friend uint32 GetTypeHash(const SVONPathFinderSettings& aSettings)
+	{
+		// The options that most often differ between agents. Equality checks the rest
+		const uint32 flags = (uint32)aSettings.myUseHierarchicalSearch | ((uint32)aSettings.myUseAbstractGraph << 1) | ((uint32)aSettings.myUseLandmarkHeuristic << 2)
+			| ((uint32)aSettings.myUseBidirectionalSearch << 3) | ((uint32)aSettings.myUseJumpPointSearch << 4) | ((uint32)aSettings.myUseThetaStar << 5)
+			| ((uint32)aSettings.myStringPullPath << 6) | ((uint32)aSettings.myResamplePath << 7) | ((uint32)aSettings.myRemoveCollinearPoints << 8)
+			| ((uint32)aSettings.myPathCostType << 9);
+		return HashCombine(HashCombine(flags, GetTypeHash(aSettings.myMaxIterations)), GetTypeHash(aSettings.myHeuristicWeight));
+	}
+};
+
+/* Point counts after each smoothing stage, and the time each took, for the last path built */
+struct UESVON_API SVONPathSmoothingStats
+{
+	int32 myNumRawPoints = 0;
+	int32 myNumPulledPoints = 0;
+	int32 myNumResampledPoints = 0;
+	int32 myNumFinalPoints = 0;
+
+	double myPullMilliseconds = 0.0;
+	double myResampleMilliseconds = 0.0;
+	double myCollinearMilliseconds = 0.0;
+};
+
+/* A single start/target query for SVONPathFinder::FindPaths */
+struct UESVON_API SVONPathRequest
+{
+	SVONLink myStart;
+	SVONLink myTarget;
+
+	SVONPathRequest() {}
+	SVONPathRequest(const SVONLink& aStart, const SVONLink& aTarget)
+		: myStart(aStart),
+		myTarget(aTarget) {}
+};
+
+/* Output slot for SVONPathFinder::FindPaths */
+struct UESVON_API SVONPathResult
+{
+	int myResult = 0;
+	ESVONPathStatus myStatus = ESVONPathStatus::Failed;
+	int32 myNumIterations = 0;
+	SVONPath myPath;
+};
+
+/* Open set entry for the heap based searches */
+struct SVONSearchEntry
+{
+	SVONLink myLink;
+	float myGScore;
+	float myFScore;
+};
+
 class UESVON_API SVONPathFinder
 {
 public:
-	SVONPathFinder(const ASVONVolume& aVolume, bool aDebugOpenNodes, UWorld* aWorld, TArray<FVector>& aDebugPoints)
+	SVONPathFinder(const ASVONVolume& aVolume, bool aDebugOpenNodes, UWorld* aWorld, TArray<FVector>& aDebugPoints, const SVONPathFinderSettings& aSettings = SVONPathFinderSettings())
 		: myVolume(aVolume), 
+		myDebugPoints(aDebugPoints),
 		myDebugOpenNodes (aDebugOpenNodes),
 		myWorld(aWorld),
-		myDebugPoints(aDebugPoints) {};
+		mySettings(aSettings) {};
 	~SVONPathFinder() {};
 
-	/* Performs an A* search from start to target navlink */
+	/* 
+	 * Performs an A* search from start to target navlink. Returns 1 if a complete path was found.
+	 * If a search limit is hit, GetStatus() is Partial and the path leads towards the goal as far as we got
+	 */
 	int FindPath(const SVONLink& aStart, const SVONLink& aTarget, FNavPathSharedPtr* oPath);
 
+	/* 
+	 * Carries on a search that ended Partial, from the open and closed sets it stopped with, under a fresh budget.
+	 * The volume must not have been regenerated in between. Any other status just returns the last result
+	 */
+	int ResumePath(FNavPathSharedPtr* oPath);
+
+	/* Changes the iteration and time limits for the next FindPath or ResumePath */
+	void SetSearchLimits(int32 aMaxIterations, float aMaxMilliseconds);
+
+	/* 
+	 * Runs a batch of queries across worker threads, writing each result into the matching output slot.
+	 * Each worker owns one pathfinder and reuses its scratch containers for every query it picks up.
+	 * aMaxWorkers <= 0 uses every available worker thread
+	 */
+	static void FindPaths(const ASVONVolume& aVolume, TArrayView<const SVONPathRequest> aRequests, TArrayView<SVONPathResult> oResults, int32 aMaxWorkers = 0, const SVONPathFinderSettings& aSettings = SVONPathFinderSettings());
+
 	const SVONPath& GetPath() const { return myPath; }
 	const FNavigationPath& GetNavPath();  
 
+	/* Number of nodes expanded by the last FindPath call, across every search it ran */
+	int32 GetNumIterations() const { return myNumIterations; }
+
+	/* How the last FindPath call ended */
+	ESVONPathStatus GetStatus() const { return myStatus; }
+
+	const SVONPathSmoothingStats& GetSmoothingStats() const { return mySmoothingStats; }
+
 private:
 	SVONPath myPath;
 
@@ -38,9 +190,51 @@ private:
 	TMap<SVONLink, float>    myGScore;
 	TMap<SVONLink, float>    myFScore;
 
+	// The backward half of a bidirectional search, the forward half uses the containers above
+	TArray<SVONSearchEntry> myForwardOpen;
+	TArray<SVONSearchEntry> myBackwardOpen;
+	TSet<SVONLink> myBackwardClosedSet;
+	TMap<SVONLink, SVONLink> myBackwardCameFrom;
+	TMap<SVONLink, float> myBackwardGScore;
+	float myBestCost = FLT_MAX;
+	SVONLink myMeetingLink;
+	// Least a step can cost per unit of distance under the cost type, times the heuristic weight
+	float myBidirectionalHeuristicScale = 1.f;
+
+	// Direction each link was reached in during jump point search, -1 if it wasn't reached by a jump
+	TMap<SVONLink, int8> myJumpDirections;
+	int8 myJumpDirection = -1;
+	bool myUseJumps = false;
+
+	// Every link position of the path being built, and scratch for the smoothing stages
+	TArray<FVector> myPathPoints;
+	TArray<FVector> mySmoothingScratch;
+	SVONPathSmoothingStats mySmoothingStats;
+
+	// Scratch for neighbour gathering, kept to avoid an allocation per expansion
+	TArray<SVONLink> myNeighbours;
+
 	SVONLink myCurrent;
+	SVONLink myStart;
 	SVONLink myGoal;
 
+	// Iterations and start time of the current FindPath, which the settings' limits apply to
+	int32 myNumIterations = 0;
+	double mySearchStartTime = 0.0;
+	ESVONPathStatus myStatus = ESVONPathStatus::Failed;
+
+	// Landmark distances to the goal, cached per query for the ALT heuristic
+	TArray<float> myGoalLandmarkDistances;
+
+	// Coarse corridor restricting the search, one set of codes per layer from myCorridorLayer up
+	TArray<TSet<mortoncode_t>> myCorridor;
+	layerindex_t myCorridorLayer = 0;
+	bool myUseCorridor = false;
+
+	// The expanded link with the lowest heuristic, where a partial path leads to
+	SVONLink myBestLink;
+	float myBestHeuristic = FLT_MAX;
+
 	const ASVONVolume& myVolume;
 
 	TArray<FVector>& myDebugPoints;
@@ -48,15 +242,74 @@ private:
 	bool myDebugOpenNodes;
 	UWorld* myWorld;
 
+	SVONPathFinderSettings mySettings;
+
 	/* A* heuristic calculation */
 	float HeuristicScore(const SVONLink& aStart, const SVONLink& aTarget);
 
+	/* Bidirectional search's heuristic, which has to be consistent on both sides for its stopping test: straight line distance, scaled for the cost type */
+	float BidirectionalHeuristic(const SVONLink& aStart, const SVONLink& aTarget);
+
 	/* Distance between two links */
 	float DistanceBetween(const SVONLink& aStart, const SVONLink& aTarget);
 
+	/* Cost of moving between two neighbouring links, per the settings' cost type */
+	float TraversalCost(const SVONLink& aStart, const SVONLink& aTarget);
+
+	/* Has the current FindPath used up the settings' iteration or time limit? */
+	bool IsOutOfBudget() const;
+
+	/* Side length of the node or subnode a link points to */
+	float GetLinkSize(const SVONLink& aLink) const;
+
 	void ProcessLink(const SVONLink& aNeighbour);
 
+	/* Octree line of sight between two link positions */
+	bool HasLineOfSight(const SVONLink& aStart, const SVONLink& aTarget) const;
+
+	/* The A* search itself, restricted to the corridor if we have one. Runs until it finishes or the budget's gone, so it can be resumed */
+	void StartSearchUnidirectional();
+	int SearchPath(FNavPathSharedPtr* oPath);
+
+	/* Two A* searches, from the start and from the goal, expanding whichever frontier is smaller */
+	void StartSearchBidirectional();
+	int SearchPathBidirectional(FNavPathSharedPtr* oPath);
+
+	/* Sets up whichever search the settings ask for, between myStart and myGoal */
+	void StartSearch();
+
+	/* Runs the search that was started, falling back to the full octree if the corridor didn't lead anywhere */
+	int ContinueSearch(FNavPathSharedPtr* oPath);
+	int RunSearch(FNavPathSharedPtr* oPath);
+
+	/* 
+	 * Jump point search over leaf subnodes. Axes are turned onto in Z, Y, X order, so runs along X never branch unless forced.
+	 * A jump runs on through as many leaves as it can, and stops at forced neighbours, where the open space beside it changes,
+	 * at the goal, or on reaching open space ahead
+	 */
+	bool IsLeafSubnode(const SVONLink& aLink) const;
+	SVONLink Jump(const SVONLink& aLink, int32 aDirection) const;
+	/* Blocked mask of the row beside a leaf row. oOpenLink is the open space there, if the row is a bigger free node */
+	uint32 GetJumpSideRow(nodeindex_t aNodeIndex, uint_fast64_t aGrid, uint_fast64_t aBase, int32 aAxis, int32 aSide, bool aReversed, SVONLink& oOpenLink) const;
+	void ProcessJumpSuccessors();
+	/* Puts back the subnodes skipped between jump points */
+	void ExpandJumps(TArray<SVONLink>& aLinks) const;
+
+	/* Coarse grid search on myCorridorLayer. Partially blocked cells are treated as traversable, at a penalty */
+	bool BuildCorridor(const SVONLink& aStart, const SVONLink& aGoal);
+	bool GetCorridorCell(const SVONLink& aLink, FIntVector& oCell) const;
+	bool IsInCorridor(const SVONLink& aLink) const;
+
 	/* Constructs the path by navigating back through our CameFrom map */
 	void BuildPath(TMap<SVONLink, SVONLink>& aCameFrom, SVONLink aCurrent, FNavPathSharedPtr* oPath);
 
+	/* Constructs the path from a start to goal list of links. Set myStatus first, a partial path keeps its last point */
+	void BuildPathFromLinks(const TArray<SVONLink>& aLinks, FNavPathSharedPtr* oPath);
+
+	/* Runs whichever smoothing stages the settings ask for, on a start to goal list of points */
+	void SmoothPath(TArray<FVector>& aPoints);
+	void StringPullPath(TArray<FVector>& aPoints);
+	void ResamplePath(TArray<FVector>& aPoints);
+	void RemoveCollinearPoints(TArray<FVector>& aPoints);
+
 };
\ No newline at end of file
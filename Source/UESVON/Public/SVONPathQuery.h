@@ -0,0 +1,69 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SVONLink.h"
+#include "SVONPath.h"
+#include "SVONPathFinder.h"
+
+/* Everything an async path query produces. Owned by the query, never written through caller pointers */
+struct UESVON_API SVONPathQueryResult
+{
+	int myResult = 0;
+	ESVONPathStatus myStatus = ESVONPathStatus::Failed;
+	// A partial result is a usable head start, a later delivery will follow with the final path
+	bool myIsPartial = false;
+	SVONPath myPath;
+	// Where the path should end: the requested target, or the free point it was snapped to if it was in blocked space
+	FVector myTargetPosition = FVector::ZeroVector;
+	TArray<FVector> myDebugPoints;
+};
+
+/* Called on the game thread when an async path query has a result (see SVONPathQueryResult::myIsPartial). Never called for cancelled queries */
+DECLARE_DELEGATE_OneParam(FSVONPathQueryComplete, const SVONPathQueryResult&);
+
+/* State shared between an in-flight query, its task and its handle */
+struct UESVON_API SVONPathQueryState
+{
+	SVONLink myStart;
+	SVONLink myTarget;
+	bool myDebugOpenNodes = false;
+	SVONPathFinderSettings mySettings;
+	// If set, first run a search capped at this many iterations and deliver its partial path early
+	int32 myPartialIterations = 0;
+
+	FThreadSafeBool myIsCancelled;
+	FThreadSafeBool myIsComplete;
+
+	SVONPathQueryResult myResult;
+	FSVONPathQueryComplete myOnComplete;
+};
+
+typedef TSharedPtr<SVONPathQueryState, ESPMode::ThreadSafe> SVONPathQueryStatePtr;
+
+/* Handle to an async path query, used to cancel it or check on it */
+class UESVON_API FSVONPathQueryHandle
+{
+public:
+	FSVONPathQueryHandle() {}
+	explicit FSVONPathQueryHandle(const SVONPathQueryStatePtr& aState)
+		: myState(aState) {}
+
+	/* Was a query actually started? */
+	bool IsValid() const { return myState.IsValid(); }
+
+	/* Is the query still waiting to deliver its result? */
+	bool IsPending() const { return myState.IsValid() && !myState->myIsComplete && !myState->myIsCancelled; }
+
+	/* Stop the query. The search is skipped if it hasn't started, and the completion delegate won't fire */
+	void Cancel()
+	{
+		if (myState.IsValid())
+		{
+			myState->myIsCancelled = true;
+		}
+		myState.Reset();
+	}
+
+private:
+	SVONPathQueryStatePtr myState;
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "SVONLink.h"
+#include "SVONPath.h"
+#include "SVONPathFinder.h"
+
+class ASVONVolume;
+
+enum class ESVONPathPriority : uint8
+{
+	Low,
+	Normal,
+	High,
+	Num
+};
+
+/* 
+ * Called on the game thread when a scheduled request has been processed. A Partial status means the request's own limits
+ * stopped the search, and the path leads as close to the target as it got
+ */
+DECLARE_DELEGATE_TwoParams(FSVONScheduledPathComplete, ESVONPathStatus, const SVONPath&);
+
+/*
+ * Per-world queue of path requests, processed on the game thread under a per-frame time and iteration budget.
+ * Requests for the same start/target link pair in the same volume, with the same settings, are merged, and all callers are notified.
+ * A search that runs out of frame budget is kept, and carries on from where it stopped next frame.
+ */
+class UESVON_API SVONPathScheduler : public FTickableGameObject
+{
+public:
+	SVONPathScheduler(UWorld* aWorld);
+	virtual ~SVONPathScheduler() {};
+
+	/* Get (or create) the scheduler for this world */
+	static SVONPathScheduler& Get(UWorld* aWorld);
+
+	/* 
+	 * Queue a path request. Returns false if the request couldn't be queued. 
+	 * The settings' own limits cap the whole search, however many frames it takes. Only requests with the same settings are merged
+	 */
+	bool RequestPath(ASVONVolume& aVolume, const SVONLink& aStart, const SVONLink& aTarget, ESVONPathPriority aPriority, const SVONPathFinderSettings& aSettings, const FSVONScheduledPathComplete& aOnComplete);
+
+	/* Set the per-frame processing budget, 0 for no limit. The request at the front of the queue always gets some of it */
+	void SetFrameBudget(float aMaxMilliseconds, int32 aMaxIterations);
+
+	/* Number of distinct requests waiting to be processed */
+	int32 GetQueueDepth() const { return myRequests.Num(); }
+
+	/* Queue-to-completion latency of recently completed requests, in milliseconds. aPercentile is 0-100 */
+	float GetLatencyPercentile(float aPercentile) const;
+
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return myRequests.Num() > 0; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return myWorld.Get(); }
+	//~ End FTickableGameObject Interface
+
+private:
+	struct SVONRequestKey
+	{
+		const ASVONVolume* myVolume;
+		SVONLink myStart;
+		SVONLink myTarget;
+		// Searches with other settings can give a different kind of path, so they're separate requests
+		SVONPathFinderSettings mySettings;
+
+		bool operator==(const SVONRequestKey& aOther) const
+		{
+			return myVolume == aOther.myVolume && myStart == aOther.myStart && myTarget == aOther.myTarget && mySettings == aOther.mySettings;
+		}
+
+		friend uint32 GetTypeHash(const SVONRequestKey& aKey)
+		{
+			return HashCombine(HashCombine(HashCombine(PointerHash(aKey.myVolume), GetTypeHash(aKey.myStart)), GetTypeHash(aKey.myTarget)), GetTypeHash(aKey.mySettings));
+		}
+	};
+
+	// A search in progress. Holds a path query on the volume, so it can't be regenerated under us between frames
+	struct SVONScheduledSearch
+	{
+		ASVONVolume& myVolume;
+		SVONPathFinder myPathFinder;
+		int32 myNumIterations = 0;
+		float myMilliseconds = 0.f;
+
+		SVONScheduledSearch(ASVONVolume& aVolume, const SVONPathFinderSettings& aSettings, TArray<FVector>& aDebugPoints);
+		~SVONScheduledSearch();
+	};
+
+	struct SVONScheduledRequest
+	{
+		TWeakObjectPtr<ASVONVolume> myVolume;
+		SVONRequestKey myKey;
+		ESVONPathPriority myPriority;
+		double myQueuedTime;
+		TSharedPtr<SVONScheduledSearch> mySearch;
+		TArray<FSVONScheduledPathComplete> myCallbacks;
+	};
+
+	TWeakObjectPtr<UWorld> myWorld;
+
+	// Pending requests by id, and the id of the pending request for each start/target pair and settings
+	TMap<uint32, SVONScheduledRequest> myRequests;
+	TMap<SVONRequestKey, uint32> myRequestIds;
+
+	// FIFO of request ids for each priority. Ids that have already been processed are skipped
+	TArray<uint32> myQueues[(uint8)ESVONPathPriority::Num];
+	int32 myQueueHeads[(uint8)ESVONPathPriority::Num];
+
+	uint32 myNextRequestId = 1;
+
+	float myMaxMilliseconds = 2.0f;
+	int32 myMaxIterations = 5000;
+
+	// Scheduled searches never record open nodes, but the pathfinder wants somewhere to put them
+	TArray<FVector> myDebugPoints;
+
+	// Ring buffer of recent latencies (ms)
+	TArray<float> myLatencies;
+	int32 myNextLatency = 0;
+
+	bool PopNextRequest(uint32& oRequestId);
+	/* Searches for up to the given budget. Returns false if the search ran out of it and needs another go */
+	bool ProcessRequest(SVONScheduledRequest& aRequest, int32 aMaxIterations, float aMaxMilliseconds, int32& oIterations);
+	void CompleteRequest(SVONScheduledRequest& aRequest);
+	void AddLatency(float aMilliseconds);
+
+	static void OnWorldCleanup(UWorld* aWorld, bool aSessionEnded, bool aCleanupResources);
+	static TMap<TWeakObjectPtr<UWorld>, TSharedPtr<SVONPathScheduler>> ourSchedulers;
+};
@@ -12,6 +12,17 @@
 #include "SVONVolume.generated.h"
 
 
+/* Where a raycast through the octree was stopped */
+struct UESVON_API SVONRaycastHit
+{
+	// Where the segment enters the blocked voxel
+	FVector myPosition = FVector::ZeroVector;
+	// The blocked voxel, in leaf voxel coordinates
+	FIntVector myVoxel = FIntVector::ZeroValue;
+	// Fraction of the way along the segment
+	float myTime = 0.f;
+};
+
 /**
  * 
  */
@@ -52,52 +63,222 @@ public:
 	int32 myVoxelPower = 3;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "UESVON")
 	TEnumAsByte<ECollisionChannel> myCollisionChannel;
+	// Build an abstract cluster graph on generation, for fast long-range queries
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "UESVON")
+	bool myBuildAbstractGraph = false;
+	// The layer whose nodes are the abstract graph's clusters
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "UESVON", meta = (EditCondition = "myBuildAbstractGraph", ClampMin = "1", ClampMax = "12"))
+	int32 myClusterLayer = 2;
+	// Number of landmarks to precompute distance tables for, for the ALT heuristic. 0 to disable
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "UESVON", meta = (ClampMin = "0", ClampMax = "32"))
+	int32 myNumLandmarks = 0;
+	// Navigate on a pointerless copy of the octree, deriving child and parent links from occupancy bits. Smaller, with slower code lookups
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "UESVON")
+	bool myUseCompactLayout = false;
 
 	bool Generate();
 
 	const FVector& GetOrigin() const { return myOrigin; }
 	const FVector& GetExtent() const { return myExtent; }
+	/* The volume's min corner, where morton code 0 is */
+	const FVector& GetZOrigin() const { return myZOrigin; }
+	/* 1 / the size of a leaf voxel, for turning local positions into voxel coordinates with a multiply */
+	float GetInvLeafVoxelSize() const { return myInvLeafVoxelSize; }
 	const uint8 GetMyNumLayers() const { return myNumLayers; }
-	const TArray<SVONNode>& GetLayer(layerindex_t aLayer) const;
+	const SVONNodeArena& GetNodeArena() const { return myData.myNodeArena; }
+
+	/* 
+	 * Node reads, from the packed arena or the compact layout, whichever this volume was generated with.
+	 * Once generation is done these are the only copy of the nodes: the SVONNode layers are freed
+	 */
+	FORCEINLINE int32 GetNumNodes(layerindex_t aLayer) const
+	{
+		return myData.myLinearOctree.IsBuilt() ? myData.myLinearOctree.GetNumNodes(aLayer) : myData.myNodeArena.GetNumNodes(aLayer);
+	}
+	FORCEINLINE SVONLink GetNodeFirstChild(layerindex_t aLayer, nodeindex_t aIndex) const
+	{
+		return myData.myLinearOctree.IsBuilt() ? myData.myLinearOctree.GetFirstChild(aLayer, aIndex) : myData.myNodeArena.GetFirstChild(aLayer, aIndex);
+	}
+	FORCEINLINE const SVONLink* GetNodeNeighbours(layerindex_t aLayer, nodeindex_t aIndex) const
+	{
+		return myData.myLinearOctree.IsBuilt() ? myData.myLinearOctree.GetNeighbours(aLayer, aIndex) : myData.myNodeArena.GetNeighbours(aLayer, aIndex);
+	}
+	FORCEINLINE SVONLink GetNodeParent(layerindex_t aLayer, nodeindex_t aIndex) const
+	{
+		return myData.myLinearOctree.IsBuilt() ? myData.myLinearOctree.GetParent(aLayer, aIndex) : myData.myNodeArena.GetParent(aLayer, aIndex);
+	}
+	/* A lookup in the arena, but a walk up the parents in the compact layout. Hot loops should keep the codes they descended by */
+	FORCEINLINE mortoncode_t GetNodeCode(layerindex_t aLayer, nodeindex_t aIndex) const
+	{
+		return myData.myLinearOctree.IsBuilt() ? myData.myLinearOctree.GetCode(aLayer, aIndex) : myData.myNodeArena.GetCode(aLayer, aIndex);
+	}
 	float GetVoxelSize(layerindex_t aLayer) const;
+	int32 GetNodesPerSide(layerindex_t aLayer) const;
+
+	/* 
+	 * A layer as SVONNodes. These aren't kept once generation is done, so the layer is unpacked from the node accessors into
+	 * a copy on first use, which lives until the volume regenerates. Use the accessors above instead
+	 */
+	DEPRECATED(4.19, "The SVONNode layers are freed after generation. Use GetNumNodes, GetNodeCode, GetNodeFirstChild and GetNodeNeighbours instead.")
+	const TArray<SVONNode>& GetLayer(layerindex_t aLayer) const;
+	DEPRECATED(4.19, "The SVONNode layers are freed after generation. Use GetNodeCode, GetNodeFirstChild and GetNodeNeighbours instead.")
+	const SVONNode& GetNode(const SVONLink& aLink) const;
+
+	/* Binary search a layer (which is sorted by code) for the node with this code */
+	bool GetIndexForCode(layerindex_t aLayer, mortoncode_t aCode, nodeindex_t& oIndex) const;
 
 	bool IsReadyForNavigation();
+
+	/* Async path queries read the octree off the game thread. While any are in flight, we won't regenerate or finish destroying */
+	void BeginPathQuery() const { myNumPendingQueries.Increment(); }
+	void EndPathQuery() const { myNumPendingQueries.Decrement(); }
+	virtual bool IsReadyForFinishDestroy() override;
 	
 	bool GetLinkPosition(const SVONLink& aLink, FVector& oPosition) const;
 	bool GetNodePosition(layerindex_t aLayer, mortoncode_t aCode, FVector& oPosition) const;
-	const SVONNode& GetNode(const SVONLink& aLink) const;
 	const SVONLeafNode& GetLeafNode(nodeindex_t aIndex) const;
 
 	void GetLeafNeighbours(const SVONLink& aLink, TArray<SVONLink>& oNeighbours) const;
+	/* The free neighbour of a leaf subnode in one of the SVONStatics::dirs, false if it's blocked or off the edge */
+	bool GetLeafNeighbour(const SVONLink& aLink, int32 aDirection, SVONLink& oNeighbour) const;
 	void GetNeighbours(const SVONLink& aLink, TArray<SVONLink>& oNeighbours) const;
 
+	/* Leaf or node neighbours, whichever applies to this link */
+	void GetNavNeighbours(const SVONLink& aLink, TArray<SVONLink>& oNeighbours) const;
+
+	/* The free space across each face of a free link. Neighbours with children are resolved down to their childless nodes and free subnodes on the shared face */
+	void GetFreeNeighbours(const SVONLink& aLink, TArray<SVONLink>& oNeighbours) const;
+
+	const SVONAbstractGraph& GetAbstractGraph() const { return myData.myAbstractGraph; }
+
+	int32 GetNumLandmarks() const { return myData.myLandmarkDistances.Num(); }
+	/* Shortest path distance from a landmark to a flat nav index, FLT_MAX if it can't be reached */
+	float GetLandmarkDistance(int32 aLandmark, int32 aNavIndex) const { return myData.myLandmarkDistances[aLandmark][aNavIndex]; }
+
+	/* Calls aFunction for every link the pathfinder could visit: every node, or every free subnode of a leaf node */
+	void ForEachNavLink(TFunctionRef<void(const SVONLink&)> aFunction) const;
+	/* As ForEachNavLink, but only free space: every childless node, and every free subnode of a leaf node */
+	void ForEachFreeLink(TFunctionRef<void(const SVONLink&)> aFunction) const;
+
+	/*
+	 * Calls aFunction for every free node and free leaf subnode touching a box. Each layer's box is decomposed into morton intervals,
+	 * which are binary searched in the (code sorted) layer, so only nodes near the box are visited
+	 */
+	void ForEachFreeLinkInBox(const FBox& aBox, TFunctionRef<void(const SVONLink&)> aFunction) const;
+	/* As ForEachFreeLinkInBox, for the free nodes and subnodes touching a sphere */
+	void ForEachFreeLinkInSphere(const FVector& aCentre, float aRadius, TFunctionRef<void(const SVONLink&)> aFunction) const;
+
+	/* Dense index of a link, unique across all layers and leaf subnodes. INDEX_NONE if the link isn't valid */
+	int32 GetNavIndex(const SVONLink& aLink) const;
+	int32 GetNumNavIndices() const { return myData.myNumNavIndices; }
+
+	/* Connected free-space component of a link, INDEX_NONE if it doesn't have one */
+	int32 GetComponent(const SVONLink& aLink) const;
+	int32 GetNumComponents() const { return myData.myNumComponents; }
+
+	/* A random free point, uniformly distributed over free space. Restricted to one connected component unless aComponent is INDEX_NONE */
+	bool GetRandomNavigablePoint(FRandomStream& aRandom, FVector& oPosition, int32 aComponent = INDEX_NONE) const;
+	/* Adds aNumPoints random free points to oPositions, returning how many it added */
+	int32 GetRandomNavigablePoints(int32 aNumPoints, FRandomStream& aRandom, TArray<FVector>& oPositions, int32 aComponent = INDEX_NONE) const;
+	/* 
+	 * As GetRandomNavigablePoints, but only inside a sphere. Small nodes are drawn from the free volume running totals over the
+	 * morton intervals the sphere's bounds cover, so the cost follows the number of intervals rather than the number of links.
+	 * Returns how many points it added, which can be fewer than aNumPoints: none if there's no free space in the sphere,
+	 * and fewer if too many draws land outside it or in another component
+	 */
+	int32 GetRandomNavigablePointsInRadius(const FVector& aCentre, float aRadius, int32 aNumPoints, FRandomStream& aRandom, TArray<FVector>& oPositions, int32 aComponent = INDEX_NONE) const;
+
+	/* Could a path exist between these links? Constant time, returns true if we don't know */
+	bool AreLinksConnected(const SVONLink& aStart, const SVONLink& aTarget) const;
+
+	/* Is this position in a blocked leaf voxel, or outside the volume? Reads only the octree, so it's safe off the game thread */
+	bool IsPositionBlocked(const FVector& aPosition) const;
+
+	/* Is the segment clear of blocked voxels? */
+	bool HasLineOfSight(const FVector& aStart, const FVector& aEnd) const;
+
+	/* 
+	 * Walks the octree along a segment, stepping over each free node in one go and only visiting leaf voxels inside leaf nodes.
+	 * Returns true and fills oHit if the segment hits a blocked voxel. Parts of the segment outside the volume are ignored
+	 */
+	bool Raycast(const FVector& aStart, const FVector& aEnd, SVONRaycastHit& oHit) const;
+
+	/* Integer leaf voxel coordinate of a position, false if it's outside the volume */
+	bool GetVoxelCoordinate(const FVector& aPosition, FIntVector& oVoxel) const;
+
+	/* The nav link containing a leaf voxel coordinate: the free node it's in, or its leaf subnode. False if it's blocked or outside */
+	bool GetLinkForVoxel(const FIntVector& aVoxel, SVONLink& oLink) const;
+
+	/* Does this node's cube contain a leaf voxel coordinate? Also false if the node doesn't exist */
+	bool NodeContainsVoxel(layerindex_t aLayer, nodeindex_t aNodeIndex, const FIntVector& aVoxel) const;
+
+	/* As GetLinkForVoxel, but descending from a node already known to contain the voxel rather than from the top layer */
+	bool GetLinkForVoxelFromNode(layerindex_t aLayer, nodeindex_t aNodeIndex, const FIntVector& aVoxel, SVONLink& oLink) const;
+
 	
 private:
 	bool myIsReadyForNavigation = false;
 
+	// Mutable so queries holding a const volume can still pin it
+	mutable FThreadSafeCounter myNumPendingQueries;
+
 	FVector myOrigin;
 	FVector myExtent;
 
+	// Cached from the bounds whenever they're read, so coordinate conversion doesn't walk the components
+	FVector myZOrigin = FVector::ZeroVector;
+	TArray<float> myVoxelSizes;
+	float myInvLeafVoxelSize = 0.f;
+
 	uint8 myNumLayers = 0;
 	
 	SVONData myData;
 
+	// Layers unpacked for the deprecated GetLayer and GetNode, only built if something still calls them
+	mutable TArray<TArray<SVONNode>> myUnpackedLayers;
+	mutable FCriticalSection myUnpackedLayersLock;
+
 	// First pass rasterize results
 	TArray<TSet<mortoncode_t>> myBlockedIndices;
 
+	/* The layers as they're generated. Empty once they've been packed */
 	TArray<SVONNode>& GetLayer(layerindex_t aLayer);
 
+	/* The world space cube of a node or leaf subnode link */
+	FBox GetLinkBounds(const SVONLink& aLink) const;
+	/* Free volume of a link in leaf voxels. Nodes with children have none of their own */
+	uint64 GetLinkFreeVolume(const SVONLink& aLink) const;
+	/* The link holding the aValue'th leaf voxel of free volume, counting through a layer's running totals between aFirst and aLast */
+	SVONLink GetLinkForFreeVolume(layerindex_t aLayer, int32 aFirst, int32 aLast, uint64 aValue) const;
+	/* A uniformly random point in a link's cube */
+	FVector GetRandomPointInLink(const SVONLink& aLink, FRandomStream& aRandom) const;
+
+	/* Adds a node if it's childless, or else its descendants on the face seen from aDirection, down to free leaf subnodes */
+	void AddFaceFreeLinks(const SVONLink& aLink, int32 aDirection, TArray<SVONLink>& oLinks) const;
+
+	/* A box in leaf voxel coordinates, clipped to the volume. False if none of it is inside */
+	bool GetVoxelBox(const FBox& aBox, FIntVector& oMin, FIntVector& oMax) const;
+	/* Free links touching a box on aMinLayer and up, keeping only those whose bounds pass aFilter */
+	void ForEachFreeLinkInBox(const FBox& aBox, layerindex_t aMinLayer, TFunctionRef<bool(const FBox&)> aFilter, TFunctionRef<void(const SVONLink&)> aFunction) const;
+	/* Calls aFunction for the nodes of a layer, between aFirst and aLast, that are inside a box of that layer's coordinates */
+	void ForEachNodeInBox(layerindex_t aLayer, const FIntVector& aMin, const FIntVector& aMax, int32 aFirst, int32 aLast, TFunctionRef<void(nodeindex_t)> aFunction) const;
+	/* As ForEachNodeInBox, but calls aFunction with runs [first, last) of consecutive node indices, as the morton order splits the box up */
+	void ForEachIntervalInBox(layerindex_t aLayer, const FIntVector& aMin, const FIntVector& aMax, int32 aFirst, int32 aLast, TFunctionRef<void(int32, int32)> aFunction) const;
+
+	void CacheTransform();
+
 	bool FirstPassRasterize();
 	void RasterizeLayer(layerindex_t aLayer);
 
 
 	int32 GetNodesInLayer(layerindex_t aLayer);
-	int32 GetNodesPerSide(layerindex_t aLayer);
 
 
-	bool GetIndexForCode(layerindex_t aLayer, mortoncode_t aCode, nodeindex_t& oIndex) const;
-
 	void BuildNeighbourLinks(layerindex_t aLayer);
+	void BuildNavIndices();
+	void BuildConnectedComponents();
+	void BuildFreeVolumes();
+	void BuildLandmarks();
 	bool FindLinkInDirection(layerindex_t aLayer, const nodeindex_t aNodeIndex, uint8 aDir, SVONLink& oLinkToUpdate, FVector& aStartPosForDebug);
 	void RasterizeLeafNode(FVector& aOrigin, nodeindex_t aLeafIndex);
 	bool SetNeighbour(const layerindex_t aLayer, const nodeindex_t aArrayIndex, const dir aDirection);